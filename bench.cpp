@@ -39,6 +39,118 @@ void bench_operation(){
     std::cout << "dummy result: " << Goldilocks2::toString(ext1) << " \n";
 }
 
+// time in_place_NTT of size 2^logn with each butterfly kernel the cpu supports
+void bench_ntt(const size_t& logn, const size_t& reps = 16){
+    std::vector<Goldilocks::Element> a = random_vec_base(1ull << logn);
+    const std::pair<NTTKernel, std::string> kernels[] = {
+        {NTTKernel::Scalar, "scalar"},
+        {NTTKernel::AVX2, "avx2"},
+        {NTTKernel::AVX512, "avx512"}
+    };
+    for(const auto& [kernel, name]: kernels){
+        if(!set_ntt_kernel(kernel)){
+            std::cout << name << " kernel is not supported on this cpu\n";
+            continue;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < reps; ++i){
+            in_place_NTT(a);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration_ms = end - start;
+        std::cout << "ntt of size 2^" << logn << " with " << name << " kernel: " << duration_ms.count() / reps << " ms\n";
+    }
+    set_ntt_kernel(NTTKernel::Auto);
+}
+
+// time the merkle tree over a num_rows x num_cols base field matrix with each sha256 engine the cpu supports
+void bench_merkle(const size_t& num_rows, const size_t& num_cols, const size_t& reps = 4){
+    auto data = std::make_shared<const std::vector<Goldilocks::Element>>(random_vec_base(num_rows * num_cols));
+    const std::pair<SHA256Engine, std::string> engines[] = {
+        {SHA256Engine::Scalar, "scalar"},
+        {SHA256Engine::AVX2, "avx2"},
+        {SHA256Engine::SHANI, "sha-ni"}
+    };
+    for(const auto& [engine, name]: engines){
+        if(!set_sha256_engine(engine)){
+            std::cout << name << " engine is not supported on this cpu\n";
+            continue;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < reps; ++i){
+            MerkleTree_base mt(data, num_rows, num_cols);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration_ms = end - start;
+        std::cout << "merkle tree of " << num_rows << " x " << num_cols << " with " << name << " engine: " << duration_ms.count() / reps << " ms\n";
+    }
+    set_sha256_engine(SHA256Engine::Auto);
+}
+
+// tree shapes against each other: build time, commitment size, multiproof size and verify time for num_queries random columns
+void bench_merkle_shapes(const size_t& num_rows, const size_t& num_cols, const size_t& num_queries, const size_t& reps = 4){
+    auto data = std::make_shared<const std::vector<Goldilocks::Element>>(random_vec_base(num_rows * num_cols));
+    std::vector<size_t> queries(num_queries);
+    for(size_t& q: queries){
+        q = rand() % num_cols;
+    }
+    for(size_t log_arity: {1, 2, 3}){
+        for(size_t cap_height: {0, 4, 8}){
+            auto start = std::chrono::high_resolution_clock::now();
+            MerkleTree_base mt(data, num_rows, num_cols, {log_arity, cap_height});
+            auto mid = std::chrono::high_resolution_clock::now();
+            auto commitment = mt.MerkleCommit();
+            auto payload = mt.MerkleMultiOpen(queries);
+            bool ok = true;
+            for(size_t i = 0; i < reps; ++i){
+                ok &= MerkleTree_base::MerkleMultiVerify(commitment, payload);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double, std::milli> build_ms = mid - start, verify_ms = end - mid;
+            std::cout << "merkle arity " << (1ull << log_arity) << " cap " << commitment.cap.size() << ": build " << build_ms.count()
+                      << " ms, " << payload.siblings.size() << " siblings, verify " << verify_ms.count() / reps << " ms" << (ok ? "" : " FAILED") << "\n";
+        }
+    }
+}
+
+// ligero commitment of 2^logn base field elements with each merkle hash
+void bench_commit_hash(const size_t& logn, const uint64_t& rho_inv = 2){
+    std::vector<Goldilocks::Element> w = random_vec_base(1ull << logn);
+    const std::pair<MerkleDef::MTHash, std::string> hashes[] = {
+        {MerkleDef::MTHash::SHA256, "sha256"},
+        {MerkleDef::MTHash::Poseidon, "poseidon"}
+    };
+    for(const auto& [hash, name]: hashes){
+        MerkleDef::MTConfig config;
+        config.hash = hash;
+        auto start = std::chrono::high_resolution_clock::now();
+        ligeroProver_base prover(w, rho_inv, config);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration_ms = end - start;
+        std::cout << "commit 2^" << logn << " with " << name << " merkle tree: " << duration_ms.count() << " ms\n";
+    }
+}
+
+// ligero commitment of 2^logn base field elements with each number of rows around the square split:
+// prover time (encoding and merkle tree) against verifier time (proximity test and one opening)
+void bench_ligero_shapes(const size_t& logn, const uint64_t& rho_inv = 2, const size_t& sec_param = 100){
+    std::vector<Goldilocks::Element> w = random_vec_base(1ull << logn);
+    std::vector<Goldilocks2::Element> z = random_vec_ext(logn);
+    std::cout << "ligero 2^" << logn << " tuned log_rows: prover " << ligero_log_rows(logn, rho_inv, sec_param, LigeroTarget::Prover)
+              << ", balanced " << ligero_log_rows(logn, rho_inv, sec_param) << ", verifier " << ligero_log_rows(logn, rho_inv, sec_param, LigeroTarget::Verifier) << "\n";
+    for(size_t log_rows = logn / 2 - 4; log_rows <= logn / 2 + 8 && log_rows <= logn; log_rows += 2){
+        auto start = std::chrono::high_resolution_clock::now();
+        ligeropcs_base pcs = std::make_shared<ligeroProver_base>(w, rho_inv, MerkleDef::MTConfig(), log_rows)->commit();
+        auto mid = std::chrono::high_resolution_clock::now();
+        bool ok = ligeroVerifier::check_commit(pcs, sec_param);
+        ligeroVerifier::open(pcs, z, sec_param);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> prover_ms = mid - start, verifier_ms = end - mid;
+        std::cout << "ligero 2^" << log_rows << " x 2^" << logn - log_rows << ": prover " << prover_ms.count()
+                  << " ms, verifier " << verifier_ms.count() << " ms" << (ok ? "" : " FAILED") << "\n";
+    }
+}
+
 void bench_logup(const size_t& fsize){
     std::vector<uint64_t> t1 = trange(0, (1ull << 16) - 1);
     std::vector<uint64_t> t2(t1.size());
@@ -76,6 +188,15 @@ int main(){
     // for(auto fsize: fsizes){
     //     bench_logup(fsize);
     // }
+    // bench_ntt(15);
+    // bench_ntt(20);
+    // bench_merkle(1ull << 7, 1ull << 16);
+    // bench_merkle_shapes(1ull << 7, 1ull << 16, 200);
+    // for(size_t logn = 20; logn <= 28; logn += 4){
+    //     bench_commit_hash(logn);
+    // }
+    // bench_ligero_shapes(20);
+    // bench_ligero_shapes(24);
     bench_logup(1ull << 10);
     bench_logup(1ull << 28);
 
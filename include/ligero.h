@@ -8,38 +8,90 @@
 #include <random>
 
 #define FIELD_BITS 2 * 64
+// rows encoded back to back by one thread in rsencode_matrix, about the size of a private L2
+#define RS_GROUP_BYTES (1ull << 18)
+// fewest rows encoded together before they are written out column by column, 8 base elements fill a cache line
+#define RS_TILE_ROWS 8
+// columns of M per block of the fused lincomb, the accumulators of one block stay in L1/L2
+#define LINCOMB_BLOCK 256
+// opened entries (columns times rows) from which the verifier checks the columns across threads
+#define LIGERO_VERIFY_PARALLEL_THRESHOLD (1ull << 14)
+// log_rows of the provers: the square split, 2^floor(l/2) rows of 2^ceil(l/2) elements
+#define LIGERO_SQUARE_ROWS SIZE_MAX
 class ligeroProver_base;
 class ligeroProver_ext;
 
+// the side ligero_log_rows tunes the matrix for
+enum class LigeroTarget{
+    // many short rows: short NTTs and a small merkle tree, but long columns to open
+    Prover,
+    // short columns and a short v' to encode
+    Verifier,
+    // prover and verifier time together
+    Balanced
+};
+
+// log2 of the number of rows for a polynomial of 2^l evaluations, minimizing a cost model of the commitment
+// (row NTTs, merkle tree) and of one opening (encoding v', t columns with their paths, t from calculate_t)
+// the result is meant for the log_rows argument of the provers, which otherwise use the square split
+size_t ligero_log_rows(const size_t& l, const uint64_t& rho_inv, const size_t& sec_param, const LigeroTarget& target = LigeroTarget::Balanced);
+
 typedef struct{
-    MerkleDef::Digest mthash;
+    // merkle cap of the codewords and the shape of their tree
+    MerkleDef::MTCommitment mtcommit;
     // const ligeroProver& prover;
-    std::shared_ptr<ligeroProver_base> prover;
+    // shared with every other commitment to the same prover, the codewords are never copied
+    std::shared_ptr<const ligeroProver_base> prover;
     size_t num_rows;
     size_t num_cols;
+    // first row of this polynomial in the prover's matrix, several polynomials can share one prover and tree
+    size_t row_offset;
 }ligeropcs_base;
 
 typedef struct{
-    MerkleDef::Digest mthash;
+    // merkle cap of the codewords and the shape of their tree
+    MerkleDef::MTCommitment mtcommit;
     // const ligeroProver& prover;
-    std::shared_ptr<ligeroProver_ext> prover;
+    // shared with every other commitment to the same prover, the codewords are never copied
+    std::shared_ptr<const ligeroProver_ext> prover;
     size_t num_rows;
     size_t num_cols;
+    // first row of this polynomial in the prover's matrix, several polynomials can share one prover and tree
+    size_t row_offset;
 }ligeropcs_ext;
 
-class ligeroProver_base{
+// built once into shared storage (std::make_shared) and handed to its commitments by reference count, never copied
+class ligeroProver_base: public std::enable_shared_from_this<ligeroProver_base>{
 public:
     // code rate
     uint64_t rho_inv;
     size_t codelen;
 
 public:
-    ligeroProver_base(const MultilinearPolynomial& w, const uint64_t& rho_inv);
-    ligeroProver_base(const std::vector<uint64_t>& w, const uint64_t& rho_inv);
-    ligeroProver_base(const std::vector<Goldilocks::Element>& w, const uint64_t& rho_inv);
+    // mt_config picks the merkle cap and arity of this commitment, log_rows the shape of the matrix (see ligero_log_rows)
+    ligeroProver_base(const MultilinearPolynomial& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    ligeroProver_base(const std::vector<uint64_t>& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    ligeroProver_base(const std::vector<Goldilocks::Element>& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    // batch commitment of polynomials with the same number of evaluations: their matrices are stacked into one
+    // and a leaf of the single merkle tree is the concatenation of their column segments
+    // ws only points to the tables, they are read straight into the matrix
+    ligeroProver_base(const std::vector<const std::vector<uint64_t>*>& ws, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    ligeroProver_base(const ligeroProver_base&) = delete;
+    ligeroProver_base& operator=(const ligeroProver_base&) = delete;
+    ligeroProver_base(ligeroProver_base&&) = default;
+    ligeroProver_base& operator=(ligeroProver_base&&) = default;
+    // the prover must already be owned by a std::shared_ptr
     ligeropcs_base commit() const;
-    std::vector<Goldilocks2::Element> lincomb(const std::vector<Goldilocks2::Element>& r) const;
-    std::vector<MerkleTree_base::MTPayload> open_cols(const std::vector<size_t>& indexes) const;
+    // one commitment per polynomial of a batch, all of them share this prover and its merkle tree
+    std::vector<ligeropcs_base> commit_all() const;
+    // r^T M over the rows [first_row, first_row + r.size())
+    std::vector<Goldilocks2::Element> lincomb(const std::vector<Goldilocks2::Element>& r, const size_t& first_row = 0) const;
+    // all combinations rs[q]^T M at once, in one sweep over M
+    std::vector<std::vector<Goldilocks2::Element>> lincomb(const std::vector<std::vector<Goldilocks2::Element>>& rs, const size_t& first_row = 0) const;
+    // one multiproof for all of the columns at indexes
+    MerkleTree_base::MTMultiPayload open_cols(const std::vector<size_t>& indexes) const;
+    // rows of the committed matrix, the length of every opened column (all the polynomials of a batch)
+    size_t matrix_rows() const {return a;}
     
 private:
     // mle is a multilinear polynomial whose evaluations over the hypercube are all base field elements 
@@ -47,37 +99,54 @@ private:
 
     // num of rows, columns;
     size_t a, b;
+    // rows of one polynomial, a is a multiple of it for a batch
+    size_t poly_rows;
     // original vector
     std::vector<Goldilocks::Element> M;
-    // encoded matrix
-    std::vector<std::vector<Goldilocks::Element>> codewords;
-    // merkle hash tree of codewords
+    // merkle hash tree of the encoded matrix (a rows of codelen), which owns its column major storage
     MerkleTree_base mt_t;
 };
 
-class ligeroProver_ext{
+// built once into shared storage (std::make_shared) and handed to its commitments by reference count, never copied
+class ligeroProver_ext: public std::enable_shared_from_this<ligeroProver_ext>{
 public:
     // code rate
     uint64_t rho_inv;
     size_t codelen;
 
 public:
-    ligeroProver_ext(const MultilinearPolynomial& w, const uint64_t& rho_inv);
-    ligeroProver_ext(const std::vector<Goldilocks2::Element>& w, const uint64_t& rho_inv);
+    // mt_config picks the merkle cap and arity of this commitment, log_rows the shape of the matrix (see ligero_log_rows)
+    ligeroProver_ext(const MultilinearPolynomial& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    ligeroProver_ext(const std::vector<Goldilocks2::Element>& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    // batch commitment, see ligeroProver_base
+    ligeroProver_ext(const std::vector<const std::vector<Goldilocks2::Element>*>& ws, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config = MerkleDef::MTConfig(), const size_t& log_rows = LIGERO_SQUARE_ROWS);
+    ligeroProver_ext(const ligeroProver_ext&) = delete;
+    ligeroProver_ext& operator=(const ligeroProver_ext&) = delete;
+    ligeroProver_ext(ligeroProver_ext&&) = default;
+    ligeroProver_ext& operator=(ligeroProver_ext&&) = default;
+    // the prover must already be owned by a std::shared_ptr
     ligeropcs_ext commit() const;
-    std::vector<Goldilocks2::Element> lincomb(const std::vector<Goldilocks2::Element>& r) const;
-    std::vector<MerkleTree_ext::MTPayload> open_cols(const std::vector<size_t>& indexes) const;
+    // one commitment per polynomial of a batch, all of them share this prover and its merkle tree
+    std::vector<ligeropcs_ext> commit_all() const;
+    // r^T M over the rows [first_row, first_row + r.size())
+    std::vector<Goldilocks2::Element> lincomb(const std::vector<Goldilocks2::Element>& r, const size_t& first_row = 0) const;
+    // all combinations rs[q]^T M at once, in one sweep over M
+    std::vector<std::vector<Goldilocks2::Element>> lincomb(const std::vector<std::vector<Goldilocks2::Element>>& rs, const size_t& first_row = 0) const;
+    // one multiproof for all of the columns at indexes
+    MerkleTree_ext::MTMultiPayload open_cols(const std::vector<size_t>& indexes) const;
+    // rows of the committed matrix, the length of every opened column (all the polynomials of a batch)
+    size_t matrix_rows() const {return a;}
     
 private:
     // MultilinearPolynomial mle;
 
     // num of rows, columns;
     size_t a, b;
+    // rows of one polynomial, a is a multiple of it for a batch
+    size_t poly_rows;
     // original vector
     std::vector<Goldilocks2::Element> M;
-    // encoded matrix
-    std::vector<std::vector<Goldilocks2::Element>> codewords;
-    // merkle hash tree of codewords
+    // merkle hash tree of the encoded matrix (a rows of codelen), which owns its column major storage
     MerkleTree_ext mt_t;
 };
 
@@ -89,25 +158,54 @@ public:
     
     static bool check_commit(const ligeropcs_base& pcs, const size_t& sec_param);
     static bool check_commit(const ligeropcs_ext& pcs, const size_t& sec_param);
+    // all commitments of one shape are tested with one encoding and one column query round,
+    // the commitments of a batch (commit_all) share one path per queried column
+    static bool check_commit(const std::vector<ligeropcs_base>& pcs, const size_t& sec_param);
+    static bool check_commit(const std::vector<ligeropcs_ext>& pcs, const size_t& sec_param);
     // static bool check_commit(const ligeropcs& pcs, const size_t& sec_param);
 
     // open f(z) where f is a polynomial hold by prover
     // verification is included in this process
     static Goldilocks2::Element open(const ligeropcs_base& pcs, const std::vector<Goldilocks2::Element> &z,  const size_t& sec_param);
     static Goldilocks2::Element open(const ligeropcs_ext& pcs, const std::vector<Goldilocks2::Element> &z,  const size_t& sec_param);
+    // check_commit and the openings at all points of zs together, with a single pass of the prover over its matrix
+    // evals[q] receives f(zs[q]), false if the proximity test or any opening fails
+    static bool open(const ligeropcs_base& pcs, const std::vector<std::vector<Goldilocks2::Element>>& zs, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals);
+    static bool open(const ligeropcs_ext& pcs, const std::vector<std::vector<Goldilocks2::Element>>& zs, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals);
+    // several commitments of the same shape at one point z: the tensors are computed once and the v' of all of them are
+    // checked through one random linear combination, i.e. one encoding and one column query round (one path per commitment)
+    // evals receives the values of pcs_base, then of pcs_ext, in order
+    static bool open(const std::vector<ligeropcs_base>& pcs_base, const std::vector<ligeropcs_ext>& pcs_ext, const std::vector<Goldilocks2::Element> &z, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals);
+    // number of columns opened for a codeword of codeword_len
+    static size_t calculate_t(const size_t& sec_param, const uint64_t& rho_inv, const size_t& codeword_len, const size_t& field_bits);
 private:
     static std::mt19937_64 gen;
     static std::uniform_int_distribution<uint64_t> dist;
     static Goldilocks2::Element randnum();
     static std::vector<Goldilocks2::Element> randvec(const uint64_t& n);
+    // n draws in [0, bound), sorted and without repetitions
     static std::vector<size_t> randindexes(const uint64_t& n, const size_t& bound);
-    static std::array<std::vector<Goldilocks2::Element>, 2> calculate_lr(const size_t& num_var, const std::vector<Goldilocks2::Element> &z);
+    // tensors of the row (first log_rows variables of z) and column parts of z
+    static std::array<std::vector<Goldilocks2::Element>, 2> calculate_lr(const size_t& log_rows, const std::vector<Goldilocks2::Element> &z);
     static bool check_lincomb(const ligeropcs_base& pcs, const std::vector<Goldilocks2::Element>& r, const std::vector<Goldilocks2::Element>& comb, const size_t& t);
     static bool check_lincomb(const ligeropcs_ext& pcs, const std::vector<Goldilocks2::Element>& r, const std::vector<Goldilocks2::Element>& comb, const size_t& t);
-    static size_t calculate_t(const size_t& sec_param, const uint64_t& rho_inv, const size_t& codeword_len, const size_t& field_bits);
+    // combs[q] against rs[q] for every q on one set of opened columns
+    template <typename Tree, typename PCS>
+    static bool check_lincombs(const PCS& pcs, const std::vector<std::vector<Goldilocks2::Element>>& rs, const std::vector<std::vector<Goldilocks2::Element>>& combs, const size_t& t);
+    template <typename Tree, typename PCS>
+    static bool check_commits(const std::vector<PCS>& pcs, const size_t& sec_param);
+    template <typename Tree, typename PCS>
+    static bool query_columns(const std::vector<PCS>& pcs, const std::vector<size_t>& indexes, const std::vector<std::vector<Goldilocks2::Element>>& rs, std::vector<Goldilocks2::Element>& entries);
+    template <typename Tree, typename PCS>
+    static bool open_many(const PCS& pcs, const std::vector<std::vector<Goldilocks2::Element>>& zs, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals);
 };
 
 
 
 std::vector<Goldilocks2::Element> rsencode(const std::vector<Goldilocks2::Element> &data, const uint64_t& rho_inv);
-std::vector<Goldilocks::Element> rsencode(const std::vector<Goldilocks::Element> &data, const uint64_t& rho_inv);
\ No newline at end of file
+std::vector<Goldilocks::Element> rsencode(const std::vector<Goldilocks::Element> &data, const uint64_t& rho_inv);
+
+// encode all a rows of the row major a x b matrix M at once, codewords must already hold a * b * rho_inv elements
+// the result is column major, codeword column j (the leaf j of the merkle tree) is codewords[j * a, (j + 1) * a)
+void rsencode_matrix(const std::vector<Goldilocks::Element>& M, const size_t& a, const size_t& b, const uint64_t& rho_inv, std::vector<Goldilocks::Element>& codewords);
+void rsencode_matrix(const std::vector<Goldilocks2::Element>& M, const size_t& a, const size_t& b, const uint64_t& rho_inv, std::vector<Goldilocks2::Element>& codewords);
@@ -25,8 +25,6 @@ private:
     table_base f1, f2, t1, t2, c;
     table_ext g, h;
     std::optional<MultilinearPolynomial> polyg, polyh;
-    // intermediate tables used for last 2 sumchecks
-    table_ext denomg, denomh;
 public:
     LogupProver(const table_base& f1, const table_base& f2, const table_base& t1, const table_base& t2);
     void calculate_multiplicities();
@@ -35,7 +33,8 @@ public:
     std::array<LogupDef::pcs_base, 4> commit_ft(const uint64_t& rho_inv);
     std::array<LogupDef::pcs_ext, 2> commit_gh(const uint64_t& rho_inv);
     std::array<sProver, 2> firstProvers();
-    std::array<pProver, 2> secondProvers(const std::vector<Goldilocks2::Element>& rg, const std::vector<Goldilocks2::Element>& rh);
+    std::array<lProver, 2> secondProvers(const std::vector<Goldilocks2::Element>& rg, const std::vector<Goldilocks2::Element>& rh,
+                                         const Goldilocks2::Element& gamma, const Goldilocks2::Element& lambda);
 };
 
 class LogupVerifier{
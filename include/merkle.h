@@ -2,11 +2,18 @@
 
 #include "goldilocks_quadratic_ext.h"
 #include <openssl/sha.h>
-#include <openssl/evp.h>
 #include <cstdint>
 #include <vector>
 #include <array>
 #include <utility>
+#include <memory>
+
+// tree levels (and leaf sets) with fewer nodes than this are hashed on the calling thread only
+#define MERKLE_PARALLEL_THRESHOLD (1ull << 8)
+// opened elements of a multiproof from which its columns are hashed across threads
+#define MERKLE_VERIFY_PARALLEL_ELEMENTS (1ull << 14)
+// widest node: 2^MERKLE_MAX_LOG_ARITY children
+#define MERKLE_MAX_LOG_ARITY 3
 
 // std::array<uint8_t, 16> to_bytes(const Goldilocks2::Element& e);
 // MTtree merkle_hash(const std::vector<std::vector<Goldilocks2::Element>> &data, std::array<uint8_t, SHA256_DIGEST_LENGTH> &hash);
@@ -15,51 +22,141 @@ namespace MerkleDef{
     typedef std::array<uint8_t, SHA256_DIGEST_LENGTH> Digest;
     typedef std::vector<Digest> MTtree;
     typedef std::vector<Digest> MTPath;
+
+    enum class MTHash{
+        // big-endian bytes of the elements, multi-buffer SHA-256 (see sha256.h)
+        SHA256,
+        // goldilocks elements absorbed natively by the Poseidon sponge, cheaper to verify inside a circuit
+        Poseidon
+    };
+
+    // shape and hash of one tree, chosen per commitment
+    // nodes are stored in a binary heap layout (root 1, children of i at 2i and 2i + 1), but only every log_arity-th
+    // level is computed: a node is the hash of its 2^log_arity descendants that many levels down, concatenated.
+    // the levels above cap_height are dropped, the commitment is the 2^cap_height nodes at that level
+    // with a log2 of the leaf count that is not cap_height plus a multiple of log_arity, the top nodes have fewer children
+    typedef struct{
+        size_t log_arity = 1;
+        size_t cap_height = 0;
+        MTHash hash = MTHash::SHA256;
+    }MTConfig;
+
+    typedef struct{
+        // nodes [2^cap_height, 2^(cap_height + 1)) of the tree, in order
+        std::vector<Digest> cap;
+        MTConfig config;
+    }MTCommitment;
+
+    // read-only view of one column of a column major matrix, sharing ownership of the whole matrix
+    template <typename T>
+    class ColumnView{
+    public:
+        ColumnView(): first(nullptr), len(0){};
+        ColumnView(const std::shared_ptr<const std::vector<T>>& matrix, const size_t& offset, const size_t& len):
+            matrix(matrix), first(matrix->data() + offset), len(len){};
+        const T& operator[](const size_t& i) const {return first[i];}
+        const T* data() const {return first;}
+        const T* begin() const {return first;}
+        const T* end() const {return first + len;}
+        size_t size() const {return len;}
+    private:
+        std::shared_ptr<const std::vector<T>> matrix;
+        const T* first;
+        size_t len;
+    };
 }
 
 class MerkleTree_base{
 public:
 
     // type for a column
-    typedef std::vector<Goldilocks::Element> col_t;
+    typedef MerkleDef::ColumnView<Goldilocks::Element> col_t;
     typedef struct{
+        // the other children of every node from the leaf up to the cap, in order
         MerkleDef::MTPath path;
+        // view into the committed matrix
         col_t column;
         // this is index in the tree, not matrix!!
         size_t index;
     }MTPayload;
+    // opening of several columns at once, the top levels shared by their paths are sent once
+    typedef struct{
+        // views into the committed matrix, in the order of indexes
+        std::vector<col_t> columns;
+        // tree indexes (not matrix) of the columns, strictly increasing
+        std::vector<size_t> indexes;
+        // only the siblings that cannot be recomputed from the columns, level by level from the leaves, left to right
+        // (the children of one node that are not opened, in order)
+        MerkleDef::MTPath siblings;
+    }MTMultiPayload;
 
 private:
     MerkleDef::MTtree T;
     size_t leaf_offset;
-    std::vector<col_t> cols;
+    MerkleDef::MTConfig config;
+    // the leaves, column major: column i is data[i * num_rows, (i + 1) * num_rows)
+    std::shared_ptr<const std::vector<Goldilocks::Element>> data;
+    size_t num_rows;
+    // leaves past num_cols up to leaf_offset are padding, they have no column to open
+    size_t num_cols;
 public:
     MerkleTree_base(){};
-    MerkleTree_base(const std::vector<std::vector<Goldilocks::Element>> &data);
+    // data is a column major num_rows x num_cols matrix, every column is a leaf
+    // the tree keeps data alive and hands out views of its columns instead of copies
+    // config.cap_height is capped at the height of the tree
+    MerkleTree_base(const std::shared_ptr<const std::vector<Goldilocks::Element>>& data, const size_t& num_rows, const size_t& num_cols, const MerkleDef::MTConfig& config = MerkleDef::MTConfig());
     MTPayload MerkleOpen(const size_t& idx) const;
-    MerkleDef::Digest MerkleCommit() const {return T[1];}
-    static bool MerkleVerify(const MerkleDef::Digest& root, const MTPayload& payload);
+    // open the columns at idxs (matrix indexes, duplicates allowed) with a single multiproof
+    MTMultiPayload MerkleMultiOpen(const std::vector<size_t>& idxs) const;
+    MerkleDef::MTCommitment MerkleCommit() const;
+    static bool MerkleVerify(const MerkleDef::MTCommitment& commitment, const MTPayload& payload);
+    // every internal node on the opened paths is hashed once
+    static bool MerkleMultiVerify(const MerkleDef::MTCommitment& commitment, const MTMultiPayload& payload);
 };
 
 class MerkleTree_ext{
 public:
     // type for a column
-    typedef std::vector<Goldilocks2::Element> col_t;
+    typedef MerkleDef::ColumnView<Goldilocks2::Element> col_t;
     typedef struct{
+        // the other children of every node from the leaf up to the cap, in order
         MerkleDef::MTPath path;
+        // view into the committed matrix
         col_t column;
         // this is index in the tree, not matrix!!
         size_t index;
     }MTPayload;
+    // opening of several columns at once, the top levels shared by their paths are sent once
+    typedef struct{
+        // views into the committed matrix, in the order of indexes
+        std::vector<col_t> columns;
+        // tree indexes (not matrix) of the columns, strictly increasing
+        std::vector<size_t> indexes;
+        // only the siblings that cannot be recomputed from the columns, level by level from the leaves, left to right
+        // (the children of one node that are not opened, in order)
+        MerkleDef::MTPath siblings;
+    }MTMultiPayload;
 
 private:
     MerkleDef::MTtree T;
     size_t leaf_offset;
-    std::vector<col_t> cols;
+    MerkleDef::MTConfig config;
+    // the leaves, column major: column i is data[i * num_rows, (i + 1) * num_rows)
+    std::shared_ptr<const std::vector<Goldilocks2::Element>> data;
+    size_t num_rows;
+    // leaves past num_cols up to leaf_offset are padding, they have no column to open
+    size_t num_cols;
 public:
     MerkleTree_ext(){};
-    MerkleTree_ext(const std::vector<std::vector<Goldilocks2::Element>> &data);
+    // data is a column major num_rows x num_cols matrix, every column is a leaf
+    // the tree keeps data alive and hands out views of its columns instead of copies
+    // config.cap_height is capped at the height of the tree
+    MerkleTree_ext(const std::shared_ptr<const std::vector<Goldilocks2::Element>>& data, const size_t& num_rows, const size_t& num_cols, const MerkleDef::MTConfig& config = MerkleDef::MTConfig());
     MTPayload MerkleOpen(const size_t& idx) const;
-    MerkleDef::Digest MerkleCommit() const {return T[1];}
-    static bool MerkleVerify(const MerkleDef::Digest& root, const MTPayload& payload);
+    // open the columns at idxs (matrix indexes, duplicates allowed) with a single multiproof
+    MTMultiPayload MerkleMultiOpen(const std::vector<size_t>& idxs) const;
+    MerkleDef::MTCommitment MerkleCommit() const;
+    static bool MerkleVerify(const MerkleDef::MTCommitment& commitment, const MTPayload& payload);
+    // every internal node on the opened paths is hashed once
+    static bool MerkleMultiVerify(const MerkleDef::MTCommitment& commitment, const MTMultiPayload& payload);
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <string>
 #include <cstdint>
 
+// bookkeeping tables of the sumcheck provers with fewer entries than this are folded and summed on the calling thread only
+#define SUMCHECK_PARALLEL_THRESHOLD (1ull << 12)
 
 // store a multilinear polynomial in a vector of evaluations
 class MultilinearPolynomial{
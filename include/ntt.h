@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "goldilocks_quadratic_ext.h"
+
+// below this size an NTT (or one of its stages) runs on the calling thread only
+#define NTT_PARALLEL_THRESHOLD (1ull << 12)
+// forward transforms and LDEs whose array takes at least this many bytes (an L2 working set) use the six-step algorithm:
+// 2^15 base or 2^14 extension elements, so the Ligero row encodings of large commitments take it
+#define NTT_SIX_STEP_BYTES (1ull << 18)
+// stages with half blocks shorter than this run inline in the transform instead of through the butterfly kernels
+#define NTT_INLINE_HALF 4
+// the blocked bit-reversal and transposes work on tiles of 2^NTT_LOG_TILE x 2^NTT_LOG_TILE elements
+#define NTT_LOG_TILE 4
+// multiplicative generator of the goldilocks field, used to shift the NTT domain to a coset
+#define NTT_COSET_SHIFT 7ull
+// odd part of p - 1 = 2^32 * 3 * 5 * 17 * 257 * 65537
+#define NTT_ODD_ORDER 0xFFFFFFFFull
+
+// powers of the roots of unity for transforms of size 2^logn, see get_twiddles
+typedef struct{
+    size_t logn;
+    // stage layout: the stage with blocks of length 2h uses omega_{2h}^j for j < h, stored at [h, 2h)
+    std::vector<Goldilocks::Element> fwd;
+    // same layout with omega_{2h}^{-1}
+    std::vector<Goldilocks::Element> inv;
+    // g^i and g^{-i} for i < 2^logn, g = NTT_COSET_SHIFT
+    std::vector<Goldilocks::Element> coset;
+    std::vector<Goldilocks::Element> coset_inv;
+    // 2^{-logn}
+    Goldilocks::Element n_inv;
+}TwiddleTable;
+
+// process-wide table cache, each size is built from ROOTS on first use and never freed
+const TwiddleTable& get_twiddles(const size_t& logn);
+
+size_t highest_bit_mask(const size_t& n);
+
+// reverse the lowest logn bits of i
+size_t reverse_bits(size_t i, const size_t& logn);
+
+// iterative Cooley-Tukey NTT of size n (power of 2), natural order in and out
+// stages are split across OpenMP threads when n >= NTT_PARALLEL_THRESHOLD
+// from NTT_SIX_STEP_BYTES on it is computed as sqrt(n)-sized transforms between transpositions, through one n-entry scratch buffer
+void in_place_NTT(Goldilocks::Element* a, const size_t& n);
+void in_place_NTT(std::vector<Goldilocks::Element>& a);
+
+// inverse of in_place_NTT (including the 1/n scaling)
+void in_place_INTT(Goldilocks::Element* a, const size_t& n);
+
+// evaluate on the coset g * <omega> instead of the subgroup itself
+void in_place_coset_NTT(Goldilocks::Element* a, const size_t& n);
+
+std::vector<Goldilocks::Element> NTT(const std::vector<Goldilocks::Element>& input);
+
+// size of the power of 2 transform used to produce N evaluations
+size_t ntt_size(const size_t& N);
+
+// whether the multiplicative group has a subgroup of order N, i.e. N = r * 2^k with k <= 32 and r | NTT_ODD_ORDER
+bool has_ntt_domain(const size_t& N);
+
+// generator of the order N subgroup, chosen so that its r-th power is ROOTS[k] (N = r * 2^k, r odd)
+Goldilocks::Element domain_generator(const size_t& N);
+
+// low degree extension: evaluate the len coefficients f (highest degree first) on the whole domain of size N (power of 2)
+// same output as the zero padded transform, but the padding is never touched: the bit-reversal is fused with the copy
+// of f and the first log(N / len) stages, which would only multiply zeros, are skipped
+// the six-step algorithm is used from NTT_SIX_STEP_BYTES on, with the same pruning in its first pass
+void lde_with_ntt(const Goldilocks::Element* f, const size_t& len, const size_t& N, Goldilocks::Element* out);
+// extension field coefficients are transformed in place of their interleaved components, sharing the base field twiddles
+void lde_with_ntt(const Goldilocks2::Element* f, const size_t& len, const size_t& N, Goldilocks2::Element* out);
+
+// evaluate the polynomial with coefficients f (highest degree first) on N points of the NTT domain:
+// the powers of domain_generator(N) when has_ntt_domain(N) (mixed radix for an odd factor of N),
+// otherwise the first N points of the next power of 2 domain
+std::vector<Goldilocks::Element> eval_with_ntt(const std::vector<Goldilocks::Element>& f, const size_t& N);
+
+std::vector<Goldilocks2::Element> eval_with_ntt(const std::vector<Goldilocks2::Element>& f, const size_t& N);
+
+// same as above but into caller owned memory, out receives N values and must not overlap f
+// scratch only grows, reusing it across calls avoids per-call allocations (including the six-step buffer)
+void eval_with_ntt(const Goldilocks::Element* f, const size_t& len, const size_t& N, Goldilocks::Element* out, std::vector<Goldilocks::Element>& scratch);
+void eval_with_ntt(const Goldilocks2::Element* f, const size_t& len, const size_t& N, Goldilocks2::Element* out, std::vector<Goldilocks2::Element>& scratch);
+
+// returns vec on base field
+std::vector<Goldilocks::Element> eval_with_ntt_base(std::vector<Goldilocks2::Element> f, const size_t& N);
+
+// returns vec on ext field
+std::vector<Goldilocks2::Element> eval_with_ntt_ext(std::vector<Goldilocks2::Element> f, const size_t& N);
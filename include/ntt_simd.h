@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include "goldilocks_base_field.hpp"
+#include "goldilocks_quadratic_ext.h"
+
+/*
+butterfly kernels used by the radix-2 NTT stages:
+for j in [begin, end): (a[j], a[j + half]) <- (a[j] + w[j] * a[j + half], a[j] - w[j] * a[j + half])
+the SIMD versions handle 4 (AVX2) or 8 (AVX-512) butterflies per instruction and fall back to scalar for the tail
+*/
+typedef void (*ButterflyKernel)(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+
+// a[k] <- a[k] * w^k for k < n, the twiddle pass between the two halves of a six-step transform
+typedef void (*ScalePowersKernel)(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w);
+
+// the same on interleaved extension field elements: both components share the base field twiddles,
+// so a butterfly costs two base multiplications and one pass transforms real and imaginary parts together
+typedef void (*ExtButterflyKernel)(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+typedef void (*ExtScalePowersKernel)(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w);
+
+// kernels of one instruction set, selected together
+typedef struct{
+    ButterflyKernel butterfly;
+    ExtButterflyKernel butterfly_ext;
+    ScalePowersKernel scale_powers;
+    ExtScalePowersKernel scale_powers_ext;
+}NTTKernelSet;
+
+enum class NTTKernel{
+    Auto,       // widest kernel supported by the running cpu
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+void butterfly_scalar(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+void butterfly_avx2(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+void butterfly_avx512(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+
+void scale_powers_scalar(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w);
+void scale_powers_avx2(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w);
+void scale_powers_avx512(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w);
+
+void butterfly_ext_scalar(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+void butterfly_ext_avx2(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+void butterfly_ext_avx512(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end);
+void scale_powers_ext_scalar(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w);
+void scale_powers_ext_avx2(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w);
+void scale_powers_ext_avx512(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w);
+
+bool ntt_kernel_supported(const NTTKernel& kernel);
+
+// select the kernels used by every following NTT (mainly for benchmarks), returns false if the cpu lacks it
+bool set_ntt_kernel(const NTTKernel& kernel);
+
+// kernels currently in use, resolved from the cpu features on first call
+const NTTKernelSet& get_ntt_kernels();
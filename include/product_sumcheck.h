@@ -3,32 +3,40 @@
 #include "goldilocks_quadratic_ext.h"
 #include "mle.h"
 #include "ligero.h"
+#include "sumcheck.h"
 #include <array>
 #include <vector>
 /*
 prover for sumcheck of product three multilinear extension in O(3 * 2^l) time
 */
-class pProver{
-public:
-    pProver(const MultilinearPolynomial& p1, const MultilinearPolynomial& p2, const MultilinearPolynomial& p3);
-    void initialize();
-    std::array<Goldilocks2::Element, 4> send_message(const size_t& round,const std::vector<Goldilocks2::Element>& rands);
-    Goldilocks2::Element get_sum() const { return sum; }
-    size_t get_rounds() const { return nrnd; }
-private:
-    MultilinearPolynomial p1;
-    MultilinearPolynomial p2;
-    MultilinearPolynomial p3;
-    
-    std::vector<Goldilocks2::Element> keepTablep1;
-    std::vector<Goldilocks2::Element> keepTablep2;
-    std::vector<Goldilocks2::Element> keepTablep3;
-    inline void shrinkTable(const Goldilocks2::Element& r, const uint64_t& offset);
-    static inline Goldilocks2::Element mul(const Goldilocks2::Element& e1, const  Goldilocks2::Element& e2, const  Goldilocks2::Element& e3);
-    static inline Goldilocks2::Element lincomb(const Goldilocks2::Element& e1, const  Goldilocks2::Element& e0, const  uint64_t& r);
-    Goldilocks2::Element sum;
-    size_t nrnd;
+using pProver = SumcheckProver<3>;
+
+// frac * (gamma - p1 - lambda * p2) over the factors (p1, p2, frac), of degree 2 along every line
+// p1 and p2 are the base field tables of logup, so the denominator is never tabulated over the extension
+struct LogupCombine{
+    static constexpr size_t degree = 2;
+    Goldilocks2::Element gamma, lambda;
+
+    inline Goldilocks2::Element operator()(const std::array<Goldilocks2::Element, 3>& x) const{
+        Goldilocks2::Element res, tmp;
+        Goldilocks2::mul(tmp, lambda, x[1]);
+        Goldilocks2::sub(res, gamma, x[0]);
+        Goldilocks2::sub(res, res, tmp);
+        Goldilocks2::mul(res, res, x[2]);
+        return res;
+    }
+
+    inline Goldilocks2::Element operator()(const std::array<Goldilocks::Element, 2>& xb, const std::array<Goldilocks2::Element, 3>& x) const{
+        Goldilocks2::Element res, tmp;
+        Goldilocks2::mul(tmp, lambda, xb[1]);
+        Goldilocks2::sub(res, gamma, xb[0]);
+        Goldilocks2::sub(res, res, tmp);
+        Goldilocks2::mul(res, res, x[2]);
+        return res;
+    }
 };
+// \Sigma eq(r, x) * frac * (gamma - p1 - lambda * p2), eq(r, .) is handled in split form and never tabulated
+using lProver = SumcheckProver<3, LogupCombine, 2, true>;
 
 class pVerifier{
 public:
@@ -39,8 +47,8 @@ public:
 
     // customized sumcheck for \Sigma eq * frac * (gamma - p1 - lambda * p2)
     static bool execute_logup_sumcheck(
-        pProver& pr,
-        const MultilinearPolynomial& eqr,
+        lProver& pr,
+        const std::vector<Goldilocks2::Element>& eq_point,
         const ligeropcs_ext& frac,
         const ligeropcs_base& p1,
         const ligeropcs_base& p2,
@@ -48,10 +56,4 @@ public:
         const Goldilocks2::Element labmda,
         const size_t& sec_param
     );
-private:
-    static Goldilocks2::Element challenge();
-    static inline Goldilocks2::Element mul(const Goldilocks2::Element& e1, const  Goldilocks2::Element& e2, const  Goldilocks2::Element& e3, const  Goldilocks2::Element& e4, const  Goldilocks2::Element& e5);
-    static inline Goldilocks2::Element mul(const Goldilocks2::Element& e1, const  Goldilocks2::Element& e2, const  Goldilocks2::Element& e3);
-    static inline Goldilocks2::Element add(const Goldilocks2::Element& e1, const  Goldilocks2::Element& e2, const  Goldilocks2::Element& e3, const  Goldilocks2::Element& e4);
-    static inline void interpolate_3(Goldilocks2::Element& fr, const Goldilocks2::Element& r, const Goldilocks2::Element& f1, const Goldilocks2::Element& f2, const Goldilocks2::Element& f3, const Goldilocks2::Element& f4);
-};
\ No newline at end of file
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#define SHA256_BLOCK_BYTES 64
+#define SHA256_DIGEST_BYTES 32
+// messages hashed side by side by the AVX2 engine, one per 32-bit lane
+#define SHA256_LANES 8
+
+/*
+SHA-256 without the per-call allocation and dispatch of the EVP interface, digests are identical to OpenSSL's.
+the engines only differ in the compression function:
+    SHANI   one message at a time with the sha extensions (sha256rnds2 / sha256msg1 / sha256msg2)
+    AVX2    SHA256_LANES messages of equal length at a time, message i in 32-bit lane i
+    Scalar  portable fallback
+*/
+enum class SHA256Engine{
+    Auto,       // SHANI, otherwise AVX2, otherwise Scalar
+    Scalar,
+    SHANI,
+    AVX2
+};
+
+bool sha256_engine_supported(const SHA256Engine& engine);
+
+// select the engine used by every following hash (mainly for benchmarks), returns false if the cpu lacks it
+bool set_sha256_engine(const SHA256Engine& engine);
+
+// digest of the len bytes at data
+void sha256(const uint8_t* data, const size_t& len, uint8_t* digest);
+
+// digests of n independent messages of len bytes each: message i is data[i], its digest goes to digests[i]
+// this is where the multi-buffer engine pays off, e.g. all leaves or all nodes of one tree level
+void sha256_many(const uint8_t* const* data, const size_t& len, uint8_t* const* digests, const size_t& n);
@@ -0,0 +1,429 @@
+#pragma once
+
+#include "goldilocks_quadratic_ext.h"
+#include "mle.h"
+#include "util.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <random>
+#include <cassert>
+#include <type_traits>
+
+/*
+sumcheck of sum_b combine(p_1(b), ..., p_N(b)) over the hypercube, for N multilinear extensions p_j
+the round polynomials have degree Combine::degree and are sent as their values at X = 0, 1, ..., degree
+the first NB factors may be small-valued tables over the base field, kept there until the first fold
+with SplitEq the summand is eq(rho, b) * combine(...), eq is never tabulated
+sProver (N = 1), pProver (N = 3) and lProver (N = 3, NB = 2, SplitEq) are the instances used by logup
+*/
+namespace SumcheckDef{
+    constexpr uint64_t mul_mod(const uint64_t a, const uint64_t b){
+        return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % Goldilocks2::p);
+    }
+
+    constexpr uint64_t inv_mod(const uint64_t a){
+        uint64_t res = 1, base = a % Goldilocks2::p;
+        for(uint64_t e = Goldilocks2::p - 2; e != 0; e >>= 1){
+            if(e & 1) res = mul_mod(res, base);
+            base = mul_mod(base, base);
+        }
+        return res;
+    }
+
+    // barycentric weights of the nodes 0, 1, ..., D: w_k = 1 / prod_{j != k} (k - j)
+    template <size_t D>
+    constexpr std::array<uint64_t, D + 1> lagrange_weights(){
+        std::array<uint64_t, D + 1> w{};
+        for(size_t k = 0; k <= D; ++k){
+            uint64_t denom = 1;
+            for(size_t j = 0; j <= D; ++j){
+                if(j != k) denom = mul_mod(denom, k > j ? k - j : Goldilocks2::p - (j - k));
+            }
+            w[k] = inv_mod(denom);
+        }
+        return w;
+    }
+
+    // f(r) for the polynomial f of degree D given by f(0), ..., f(D)
+    template <size_t D>
+    inline Goldilocks2::Element interpolate(const std::array<Goldilocks2::Element, D + 1>& f, const Goldilocks2::Element& r){
+        static constexpr std::array<uint64_t, D + 1> w = lagrange_weights<D>();
+        // prefix[k] = prod_{j < k} (r - j), the suffix products are built on the way back
+        std::array<Goldilocks2::Element, D + 1> prefix;
+        prefix[0] = Goldilocks2::one();
+        for(size_t k = 0; k < D; ++k){
+            Goldilocks2::Element x;
+            Goldilocks2::sub(x, r, static_cast<uint64_t>(k));
+            Goldilocks2::mul(prefix[k + 1], prefix[k], x);
+        }
+        Goldilocks2::Element fr = Goldilocks2::zero(), suffix = Goldilocks2::one(), term;
+        for(size_t k = D + 1; k-- > 0;){
+            Goldilocks2::mul(term, prefix[k], suffix);
+            Goldilocks2::mul(term, term, f[k]);
+            Goldilocks2::mul(term, term, w[k]);
+            Goldilocks2::add(fr, fr, term);
+            Goldilocks2::Element x;
+            Goldilocks2::sub(x, r, static_cast<uint64_t>(k));
+            Goldilocks2::mul(suffix, suffix, x);
+        }
+        return fr;
+    }
+
+    // eq(a, b) for a single variable: a * b + (1 - a) * (1 - b)
+    inline Goldilocks2::Element eq1(const Goldilocks2::Element& a, const Goldilocks2::Element& b){
+        Goldilocks2::Element res, tmp;
+        Goldilocks2::mul(res, a, b);
+        Goldilocks2::add(res, res, res);
+        Goldilocks2::add(tmp, a, b);
+        Goldilocks2::sub(res, res, tmp);
+        Goldilocks2::add(res, res, static_cast<uint64_t>(1));
+        return res;
+    }
+
+    // eq(a, b) in closed form, O(l) instead of evaluating the tabulated eq(a, .)
+    inline Goldilocks2::Element eq_eval(const std::vector<Goldilocks2::Element>& a, const std::vector<Goldilocks2::Element>& b){
+        assert(a.size() == b.size());
+        Goldilocks2::Element res = Goldilocks2::one();
+        for(size_t i = 0; i < a.size(); ++i){
+            Goldilocks2::mul(res, res, eq1(a[i], b[i]));
+        }
+        return res;
+    }
+
+    // the default combining function: the product of the N factors, of degree N along every line
+    // any other one provides the same members, its degree bounds the degree of combine along a line
+    // the second call operator is only needed with base field factors: factor j < NB is xb[j] and x[j] is unused
+    template <size_t N>
+    struct Product{
+        static constexpr size_t degree = N;
+        inline Goldilocks2::Element operator()(const std::array<Goldilocks2::Element, N>& x) const{
+            Goldilocks2::Element res = x[0];
+            for(size_t j = 1; j < N; ++j){
+                Goldilocks2::mul(res, res, x[j]);
+            }
+            return res;
+        }
+
+        template <size_t NB>
+        inline Goldilocks2::Element operator()(const std::array<Goldilocks::Element, NB>& xb, const std::array<Goldilocks2::Element, N>& x) const{
+            static_assert(NB > 0 && NB <= N);
+            // base times base first, then one base times extension product per factor
+            Goldilocks::Element resb = xb[0];
+            for(size_t j = 1; j < NB; ++j){
+                resb = resb * xb[j];
+            }
+            if(NB == N) return {resb, Goldilocks::zero()};
+            Goldilocks2::Element res;
+            Goldilocks2::mul(res, x[NB], resb);
+            for(size_t j = NB + 1; j < N; ++j){
+                Goldilocks2::mul(res, res, x[j]);
+            }
+            return res;
+        }
+    };
+}
+
+// notation referce: Libra(https://eprint.iacr.org/2019/317.pdf) Algorithm 1
+// one sweep per round folds the tables with r_{i-1} and evaluates the next message, O((N + degree) * 2^l) in total
+// the NB base field tables are read with base arithmetic in the first round and folded into extension tables of half their size in the second,
+// so they take half the memory of extension tables and the first round spends base or base times extension operations on them
+// SplitEq (Gruen, Dao-Thaler): s_i(X) = eq(rho_{<i}, r_{<i}) * eq(rho_i, X) * sum_b eq(rho_{>i}, b) * combine(r_{<i}, X, b),
+// where eq(rho_{>i}, b) is the product of two tables over the high and the low half of b, each about the square root of the size
+template <size_t N, typename Combine = SumcheckDef::Product<N>, size_t NB = 0, bool SplitEq = false>
+class SumcheckProver{
+public:
+    static constexpr size_t degree = Combine::degree + SplitEq;
+    // s_i(0), s_i(1), ..., s_i(degree)
+    using Message = std::array<Goldilocks2::Element, degree + 1>;
+    using table_base = std::vector<Goldilocks::Element>;
+
+    // eq_point is rho with SplitEq, and is left empty otherwise
+    SumcheckProver(const std::array<MultilinearPolynomial, N>& ps, const Combine& combine = Combine(), const std::vector<Goldilocks2::Element>& eq_point = {});
+    // factors 0, ..., NB - 1 from base field tables, the others from ps
+    SumcheckProver(const std::array<table_base, NB>& base, const std::array<MultilinearPolynomial, N - NB>& ps, const Combine& combine = Combine(),
+                   const std::vector<Goldilocks2::Element>& eq_point = {});
+    // one polynomial per factor, e.g. sProver(g) or pProver(p1, p2, p3)
+    template <typename... Ps, typename = std::enable_if_t<NB == 0 && !SplitEq && sizeof...(Ps) == N && std::conjunction_v<std::is_same<Ps, MultilinearPolynomial>...>>>
+    SumcheckProver(const Ps&... ps): SumcheckProver(std::array<MultilinearPolynomial, N>{ps...}){}
+
+    Message send_message(const size_t& round, const std::vector<Goldilocks2::Element>& rands);
+    Goldilocks2::Element get_sum() const { return sum; }
+    size_t get_rounds() const { return nrnd; }
+private:
+    // bookkeeping tables, halved in every round from the second one on
+    // tables[j] for j < NB stays empty until the first fold, which empties base_tables
+    std::array<std::vector<Goldilocks2::Element>, N> tables;
+    std::array<table_base, NB> base_tables;
+    Combine combine;
+    Goldilocks2::Element sum;
+    size_t nrnd;
+    // rho and eq(rho_{<i}, r_{<i}), only used with SplitEq
+    std::vector<Goldilocks2::Element> rho;
+    Goldilocks2::Element eq_prefix;
+
+    void init_sum();
+    // eq(rho_first, ..., rho_{l-1}; b) = hi[b >> lo_bits] * lo[b & (2^lo_bits - 1)]
+    size_t split_eq(const size_t& first, std::vector<Goldilocks2::Element>& hi, std::vector<Goldilocks2::Element>& lo) const;
+};
+
+template <size_t N, typename Combine, size_t NB, bool SplitEq>
+SumcheckProver<N, Combine, NB, SplitEq>::SumcheckProver(const std::array<MultilinearPolynomial, N>& ps, const Combine& combine,
+                                                        const std::vector<Goldilocks2::Element>& eq_point):
+    combine(combine), sum(Goldilocks2::zero()), nrnd(ps[0].get_num_vars()), rho(eq_point), eq_prefix(Goldilocks2::one()){
+    static_assert(N > 0, "a sumcheck needs at least one factor");
+    static_assert(NB == 0, "base field factors are given as tables");
+    for(size_t j = 0; j < N; ++j){
+        assert(ps[j].get_num_vars() == nrnd);
+        tables[j] = ps[j].get_eval_table();
+    }
+    init_sum();
+}
+
+template <size_t N, typename Combine, size_t NB, bool SplitEq>
+SumcheckProver<N, Combine, NB, SplitEq>::SumcheckProver(const std::array<table_base, NB>& base, const std::array<MultilinearPolynomial, N - NB>& ps,
+                                                        const Combine& combine, const std::vector<Goldilocks2::Element>& eq_point):
+    base_tables(base), combine(combine), sum(Goldilocks2::zero()), rho(eq_point), eq_prefix(Goldilocks2::one()){
+    static_assert(NB > 0 && NB < N, "at least one factor over the extension");
+    nrnd = ps[0].get_num_vars();
+    for(size_t j = 0; j < NB; ++j){
+        assert(base_tables[j].size() == (1ull << nrnd));
+    }
+    for(size_t j = NB; j < N; ++j){
+        assert(ps[j - NB].get_num_vars() == nrnd);
+        tables[j] = ps[j - NB].get_eval_table();
+    }
+    init_sum();
+}
+
+template <size_t N, typename Combine, size_t NB, bool SplitEq>
+size_t SumcheckProver<N, Combine, NB, SplitEq>::split_eq(const size_t& first, std::vector<Goldilocks2::Element>& hi, std::vector<Goldilocks2::Element>& lo) const{
+    // rho_first goes with the highest bit of b, as in eq()
+    const size_t m = nrnd - first, lo_bits = m / 2;
+    const auto mid = rho.begin() + (first + m - lo_bits);
+    hi = eq(m - lo_bits, std::vector<Goldilocks2::Element>(rho.begin() + first, mid)).get_eval_table();
+    lo = eq(lo_bits, std::vector<Goldilocks2::Element>(mid, rho.end())).get_eval_table();
+    return lo_bits;
+}
+
+template <size_t N, typename Combine, size_t NB, bool SplitEq>
+void SumcheckProver<N, Combine, NB, SplitEq>::init_sum(){
+    assert(rho.size() == (SplitEq ? nrnd : 0));
+    // b = (bh << lo_bits) | bl, without SplitEq the low part is empty
+    std::vector<Goldilocks2::Element> eq_hi, eq_lo;
+    const size_t lo_bits = SplitEq ? split_eq(0, eq_hi, eq_lo) : 0;
+    const uint64_t nh = 1ull << (nrnd - lo_bits), nl = 1ull << lo_bits;
+    // partial sums per thread, field additions are exact so the sum does not depend on the split
+    #pragma omp parallel if((1ull << nrnd) >= SUMCHECK_PARALLEL_THRESHOLD)
+    {
+        Goldilocks2::Element part = Goldilocks2::zero(), inner = Goldilocks2::zero(), v;
+        std::array<Goldilocks2::Element, N> x;
+        std::array<Goldilocks::Element, NB> xb;
+        #pragma omp for schedule(static) nowait
+        for(uint64_t bh = 0; bh < nh; ++bh){
+            Goldilocks2::Element& acc = SplitEq ? inner : part;
+            for(uint64_t bl = 0; bl < nl; ++bl){
+                const uint64_t mask = (bh << lo_bits) | bl;
+                for(size_t j = 0; j < NB; ++j){
+                    xb[j] = base_tables[j][mask];
+                }
+                for(size_t j = NB; j < N; ++j){
+                    x[j] = tables[j][mask];
+                }
+                if constexpr (NB > 0){
+                    v = combine(xb, x);
+                }else{
+                    v = combine(x);
+                }
+                if constexpr (SplitEq) Goldilocks2::mul(v, v, eq_lo[bl]);
+                Goldilocks2::add(acc, acc, v);
+            }
+            if constexpr (SplitEq){
+                Goldilocks2::mul(inner, inner, eq_hi[bh]);
+                Goldilocks2::add(part, part, inner);
+                inner = Goldilocks2::zero();
+            }
+        }
+        #pragma omp critical
+        Goldilocks2::add(sum, sum, part);
+    }
+}
+
+template <size_t N, typename Combine, size_t NB, bool SplitEq>
+typename SumcheckProver<N, Combine, NB, SplitEq>::Message SumcheckProver<N, Combine, NB, SplitEq>::send_message(const size_t& round, const std::vector<Goldilocks2::Element>& rands){
+    Message s;
+    s.fill(Goldilocks2::zero());
+    uint64_t offset = 1ull << (nrnd - round);
+
+    // from the second round on the tables (of size 4 * offset) are folded with r_{i-1} in the same sweep that accumulates s:
+    // entries b and b + offset of the folded table come from b, b + 2 offset and b + offset, b + 3 offset of the current one
+    const bool folding = round > 1;
+    // namely r_{i-1}
+    const Goldilocks2::Element r = folding ? rands[round - 2] : Goldilocks2::zero();
+    // the base field factors are read as they are in the first round and folded out of base_tables in the second
+    const bool in_base = NB > 0 && round == 1;
+    const bool from_base = NB > 0 && round == 2;
+    std::array<Goldilocks2::Element*, N> t;
+    std::array<const Goldilocks::Element*, NB> tb;
+    for(size_t j = 0; j < NB; ++j){
+        if(from_base) tables[j].resize(offset << 1);
+        tb[j] = base_tables[j].data();
+    }
+    for(size_t j = 0; j < N; ++j){
+        t[j] = tables[j].data();
+    }
+    // b = (bh << lo_bits) | bl, without SplitEq the low part is empty
+    std::vector<Goldilocks2::Element> eq_hi, eq_lo;
+    size_t lo_bits = 0;
+    if constexpr (SplitEq){
+        if(folding) Goldilocks2::mul(eq_prefix, eq_prefix, SumcheckDef::eq1(rho[round - 2], r));
+        lo_bits = split_eq(round, eq_hi, eq_lo);
+    }
+    const uint64_t nh = offset >> lo_bits, nl = 1ull << lo_bits;
+
+    // partial sums per thread, the message is the same for any number of threads
+    #pragma omp parallel if(offset >= SUMCHECK_PARALLEL_THRESHOLD)
+    {
+        Message part, inner;
+        part.fill(Goldilocks2::zero());
+        inner.fill(Goldilocks2::zero());
+        // factors at X along the line through their entries b (X = 0) and b + offset (X = 1), and their slopes
+        std::array<Goldilocks2::Element, N> x, d;
+        std::array<Goldilocks::Element, NB> xb, db;
+        Goldilocks2::Element v;
+        #pragma omp for schedule(static) nowait
+        for(uint64_t bh = 0; bh < nh; ++bh){
+            Message& acc = SplitEq ? inner : part;
+            for(uint64_t bl = 0; bl < nl; ++bl){
+                const uint64_t b = (bh << lo_bits) | bl;
+                for(size_t j = 0; j < N; ++j){
+                    Goldilocks2::Element* tj = t[j];
+                    if(j < NB && in_base){
+                        xb[j] = tb[j][b];
+                        db[j] = tb[j][b + offset] - tb[j][b];
+                        continue;
+                    }
+                    if(j < NB && from_base){
+                        // lo + r * (hi - lo) with the difference in the base field, one base times extension product
+                        Goldilocks2::mul(d[j], r, tb[j][b + 2 * offset] - tb[j][b]);
+                        Goldilocks2::add(tj[b], d[j], tb[j][b]);
+                        Goldilocks2::mul(d[j], r, tb[j][b + 3 * offset] - tb[j][b + offset]);
+                        Goldilocks2::add(tj[b + offset], d[j], tb[j][b + offset]);
+                    }else if(folding){
+                        // r * hi + (1 - r) * lo with one multiplication
+                        Goldilocks2::sub(d[j], tj[b + 2 * offset], tj[b]);
+                        Goldilocks2::mul(d[j], d[j], r);
+                        Goldilocks2::add(tj[b], tj[b], d[j]);
+                        Goldilocks2::sub(d[j], tj[b + 3 * offset], tj[b + offset]);
+                        Goldilocks2::mul(d[j], d[j], r);
+                        Goldilocks2::add(tj[b + offset], tj[b + offset], d[j]);
+                    }
+                    x[j] = tj[b];
+                    Goldilocks2::sub(d[j], tj[b + offset], tj[b]);
+                }
+                // X = 2, 3, ... by adding the slopes again, no multiplication besides the ones in combine and the eq weight
+                // with SplitEq the sum has the degree of combine, its value at X = degree is extrapolated after the sweep
+                for(size_t k = 0; k <= Combine::degree; ++k){
+                    if constexpr (NB > 0){
+                        v = in_base ? combine(xb, x) : combine(x);
+                    }else{
+                        v = combine(x);
+                    }
+                    if constexpr (SplitEq) Goldilocks2::mul(v, v, eq_lo[bl]);
+                    Goldilocks2::add(acc[k], acc[k], v);
+                    if(k == Combine::degree) break;
+                    for(size_t j = 0; j < N; ++j){
+                        if(j < NB && in_base){
+                            xb[j] = xb[j] + db[j];
+                        }else{
+                            Goldilocks2::add(x[j], x[j], d[j]);
+                        }
+                    }
+                }
+            }
+            if constexpr (SplitEq){
+                for(size_t k = 0; k <= Combine::degree; ++k){
+                    Goldilocks2::mul(inner[k], inner[k], eq_hi[bh]);
+                    Goldilocks2::add(part[k], part[k], inner[k]);
+                }
+                inner.fill(Goldilocks2::zero());
+            }
+        }
+        #pragma omp critical
+        for(size_t k = 0; k <= degree; ++k){
+            Goldilocks2::add(s[k], s[k], part[k]);
+        }
+    }
+    if constexpr (SplitEq){
+        std::array<Goldilocks2::Element, Combine::degree + 1> q;
+        std::copy(s.begin(), s.begin() + q.size(), q.begin());
+        s[degree] = SumcheckDef::interpolate<Combine::degree>(q, Goldilocks2::Element{Goldilocks::fromU64(degree), Goldilocks::zero()});
+        // s(k) = eq(rho_{<i}, r_{<i}) * eq(rho_i, k) * q(k), where eq(rho_i, k) = 1 - rho_i + k * (2 rho_i - 1)
+        Goldilocks2::Element e, slope;
+        Goldilocks2::sub(e, Goldilocks2::one(), rho[round - 1]);
+        Goldilocks2::add(slope, rho[round - 1], rho[round - 1]);
+        Goldilocks2::sub(slope, slope, static_cast<uint64_t>(1));
+        Goldilocks2::mul(e, e, eq_prefix);
+        Goldilocks2::mul(slope, slope, eq_prefix);
+        for(size_t k = 0; k <= degree; ++k){
+            Goldilocks2::mul(s[k], s[k], e);
+            Goldilocks2::add(e, e, slope);
+        }
+    }
+    if(folding){
+        for(auto& table: tables){
+            table.resize(offset << 1);
+        }
+    }
+    if(from_base){
+        for(auto& table: base_tables){
+            table_base().swap(table);
+        }
+    }
+    return s;
+}
+
+class SumcheckVerifier{
+public:
+    /*
+    run all rounds of pr against its claimed sum: s_1(0) + s_1(1) = sum, s_{i-1}(r_{i-1}) = s_i(0) + s_i(1)
+    and finally s_l(r_l) = final_eval(r), the combination of the oracles at the challenges r = (r_1, ..., r_l)
+    final_eval returns false through its second argument when an opening fails
+    */
+    template <typename Prover, typename FinalEval>
+    static bool execute(Prover& pr, FinalEval&& final_eval);
+
+    // we use goldilocks 2-extension, so no bother specifying the field
+    static inline Goldilocks2::Element challenge(){
+        static std::random_device rd;
+        static std::mt19937_64 gen(rd());
+        std::uniform_int_distribution<uint64_t> dist(0, Goldilocks2::p - 1);
+        uint64_t randn[] = {dist(gen), dist(gen)};
+        return Goldilocks2::fromU64(randn);
+    }
+};
+
+template <typename Prover, typename FinalEval>
+bool SumcheckVerifier::execute(Prover& pr, FinalEval&& final_eval){
+    constexpr size_t D = Prover::degree;
+    const size_t nrnd = pr.get_rounds();
+    std::vector<Goldilocks2::Element> challenges;
+    challenges.reserve(nrnd);
+
+    // s_{i - 1}(r_{i - 1}), the claimed sum in the first round
+    Goldilocks2::Element expected = pr.get_sum();
+    for(size_t round = 1; round <= nrnd; ++round){
+        typename Prover::Message si = pr.send_message(round, challenges);
+        // s(0) + s(1)
+        Goldilocks2::Element ss;
+        Goldilocks2::add(ss, si[0], si[1]);
+        if(!(ss == expected)) return false;
+        challenges.push_back(challenge());
+        expected = SumcheckDef::interpolate<D>(si, challenges.back());
+    }
+
+    // final check: s_l(r_l) against the oracles
+    bool ok = true;
+    Goldilocks2::Element f_r = final_eval(challenges, ok);
+    return ok && f_r == expected;
+}
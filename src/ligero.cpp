@@ -3,10 +3,14 @@
 #include "goldilocks_quadratic_ext.h"
 #include "merkle.h"
 #include "util.h"
+#include "ntt.h"
 #include "timer.h"
 #include <cmath>
+#include <omp.h>
+#include <algorithm>
 #include <openssl/sha.h>
 #include <cassert>
+#include <type_traits>
 
 // reed solomon encode data on base field
 std::vector<Goldilocks::Element> rsencode(const std::vector<Goldilocks::Element> &data, const uint64_t& rho_inv){
@@ -15,64 +19,202 @@ std::vector<Goldilocks::Element> rsencode(const std::vector<Goldilocks::Element>
 }
 
 // reed solomon encode data on quadratic extension field
-// this is simply encode real part and imaginary part respectively and merge the results
+// both components are transformed together, the code is the base field code applied to each of them
 std::vector<Goldilocks2::Element> rsencode(const std::vector<Goldilocks2::Element> &data, const uint64_t& rho_inv){
     return eval_with_ntt(data, data.size() * rho_inv);
 }
 
-ligeroProver_base::ligeroProver_base(const MultilinearPolynomial& w, const uint64_t& rho_inv):rho_inv(rho_inv){
+// log2 of the rows of the matrix of 2^l elements, log_rows as passed to the provers
+static size_t matrix_log_rows(const size_t& l, const size_t& log_rows){
+    return log_rows == LIGERO_SQUARE_ROWS ? l >> 1 : std::min(log_rows, l);
+}
+
+// encode every row of the row major a x b matrix M into the column major a x (b * rho_inv) matrix codewords
+// each thread takes groups of rows that fit in its cache and encodes them into one reused scratch buffer,
+// the group is then scattered column by column, at least RS_TILE_ROWS consecutive elements of a column at a time
+template <typename T>
+static void rsencode_matrix_impl(const std::vector<T>& M, const size_t& a, const size_t& b, const uint64_t& rho_inv, std::vector<T>& codewords){
+    const size_t codelen = b * rho_inv;
+    assert(M.size() >= a * b && codewords.size() == a * codelen);
+    const size_t group = std::max<size_t>(RS_TILE_ROWS, RS_GROUP_BYTES / (codelen * sizeof(T)));
+    const size_t ngroups = (a + group - 1) / group;
+    // with fewer groups than threads the rows go one by one and every NTT is parallel instead
+    const bool parallel = ngroups >= static_cast<size_t>(omp_get_max_threads()) && omp_get_max_threads() > 1;
+
+    #pragma omp parallel if(parallel)
+    {
+        std::vector<T> rows, scratch;
+        #pragma omp for schedule(dynamic, 1)
+        for(size_t g = 0; g < ngroups; ++g){
+            const size_t start = g * group, end = std::min(a, start + group);
+            rows.resize((end - start) * codelen);
+            for(size_t i = start; i < end; ++i){
+                eval_with_ntt(M.data() + i * b, b, codelen, rows.data() + (i - start) * codelen, scratch);
+            }
+            #pragma omp parallel for schedule(static) if(codelen >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel())
+            for(size_t j = 0; j < codelen; ++j){
+                T* col = codewords.data() + j * a;
+                for(size_t i = start; i < end; ++i){
+                    col[i] = rows[(i - start) * codelen + j];
+                }
+            }
+        }
+    }
+}
+
+void rsencode_matrix(const std::vector<Goldilocks::Element>& M, const size_t& a, const size_t& b, const uint64_t& rho_inv, std::vector<Goldilocks::Element>& codewords){
+    rsencode_matrix_impl(M, a, b, rho_inv, codewords);
+}
+
+void rsencode_matrix(const std::vector<Goldilocks2::Element>& M, const size_t& a, const size_t& b, const uint64_t& rho_inv, std::vector<Goldilocks2::Element>& codewords){
+    rsencode_matrix_impl(M, a, b, rho_inv, codewords);
+}
+
+// sum of products of canonical base field values, kept in 192 bits and reduced once at the end
+typedef struct{
+    unsigned __int128 lo;
+    uint64_t hi;
+}LincombAcc;
+
+static inline void acc_madd(LincombAcc& acc, const uint64_t& x, const uint64_t& y){
+    const unsigned __int128 prod = static_cast<unsigned __int128>(x) * y;
+    acc.lo += prod;
+    acc.hi += acc.lo < prod;
+}
+
+// x mod p for x < 2^128, with 2^64 = 2^32 - 1 and 2^96 = -1 mod p
+static inline uint64_t reduce128(const unsigned __int128& x){
+    const uint64_t epsilon = 0xFFFFFFFFull;
+    const uint64_t lo = static_cast<uint64_t>(x), hi = static_cast<uint64_t>(x >> 64);
+    uint64_t t0 = lo - (hi >> 32);
+    if(lo < (hi >> 32)) t0 -= epsilon;
+    const uint64_t t1 = (hi & epsilon) * epsilon;
+    uint64_t res = t0 + t1;
+    if(res < t1) res += epsilon;
+    return res >= GOLDILOCKS_PRIME ? res - GOLDILOCKS_PRIME : res;
+}
+
+// hi * 2^128 + lo mod p, with 2^128 = p - 2^32 mod p
+static inline Goldilocks::Element acc_reduce(const LincombAcc& acc){
+    const uint64_t lo = reduce128(acc.lo);
+    const uint64_t hi = reduce128(static_cast<unsigned __int128>(acc.hi) * (GOLDILOCKS_PRIME - (1ull << 32)));
+    return Goldilocks::add(Goldilocks::fromU64(lo), Goldilocks::fromU64(hi));
+}
+
+// the k combinations v_q = sum_j rs[q][j] * (row j of the row major a x b matrix at M) in a single sweep over it
+// threads take blocks of LINCOMB_BLOCK columns, each row segment of a block is read once and multiplied into all k
+// accumulators; products of the canonical components are summed without reduction, see LincombAcc
+// an extension product (r0 + r1 x)(m0 + m1 x) is kept as its four component products, 7 r1 m1 being applied at the end
+template <typename T>
+static std::vector<std::vector<Goldilocks2::Element>> lincomb_impl(const T* M, const size_t& a, const size_t& b, const std::vector<std::vector<Goldilocks2::Element>>& rs){
+    constexpr bool ext = std::is_same<T, Goldilocks2::Element>::value;
+    // components of an entry and accumulators per entry of one combination
+    constexpr size_t width = ext ? 2 : 1, parts = 2 * width;
+    const size_t k = rs.size();
+    std::vector<uint64_t> r(k * a * 2);
+    for(size_t q = 0; q < k; ++q){
+        assert(rs[q].size() == a);
+        for(size_t j = 0; j < a; ++j){
+            r[(q * a + j) * 2] = Goldilocks::toU64(rs[q][j][0]);
+            r[(q * a + j) * 2 + 1] = Goldilocks::toU64(rs[q][j][1]);
+        }
+    }
+    std::vector<std::vector<Goldilocks2::Element>> v(k, std::vector<Goldilocks2::Element>(b));
+    const size_t nblocks = (b + LINCOMB_BLOCK - 1) / LINCOMB_BLOCK;
+
+    #pragma omp parallel if(nblocks > 1 && a * b >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel())
+    {
+        std::vector<LincombAcc> acc(k * LINCOMB_BLOCK * parts);
+        uint64_t m[LINCOMB_BLOCK * width];
+        #pragma omp for schedule(static)
+        for(size_t blk = 0; blk < nblocks; ++blk){
+            const size_t i0 = blk * LINCOMB_BLOCK, w = std::min<size_t>(LINCOMB_BLOCK, b - i0);
+            std::fill(acc.begin(), acc.end(), LincombAcc{0, 0});
+            for(size_t j = 0; j < a; ++j){
+                const Goldilocks::Element* row = reinterpret_cast<const Goldilocks::Element*>(M + j * b + i0);
+                for(size_t i = 0; i < w * width; ++i){
+                    m[i] = Goldilocks::toU64(row[i]);
+                }
+                for(size_t q = 0; q < k; ++q){
+                    const uint64_t r0 = r[(q * a + j) * 2], r1 = r[(q * a + j) * 2 + 1];
+                    LincombAcc* A = acc.data() + q * LINCOMB_BLOCK * parts;
+                    for(size_t i = 0; i < w; ++i){
+                        if constexpr (ext){
+                            acc_madd(A[4 * i], r0, m[2 * i]);
+                            acc_madd(A[4 * i + 1], r1, m[2 * i + 1]);
+                            acc_madd(A[4 * i + 2], r0, m[2 * i + 1]);
+                            acc_madd(A[4 * i + 3], r1, m[2 * i]);
+                        }else{
+                            acc_madd(A[2 * i], r0, m[i]);
+                            acc_madd(A[2 * i + 1], r1, m[i]);
+                        }
+                    }
+                }
+            }
+            for(size_t q = 0; q < k; ++q){
+                const LincombAcc* A = acc.data() + q * LINCOMB_BLOCK * parts;
+                for(size_t i = 0; i < w; ++i){
+                    Goldilocks2::Element& e = v[q][i0 + i];
+                    if constexpr (ext){
+                        e[0] = Goldilocks::add(acc_reduce(A[4 * i]), Goldilocks::mul(Goldilocks::fromU64(7), acc_reduce(A[4 * i + 1])));
+                        e[1] = Goldilocks::add(acc_reduce(A[4 * i + 2]), acc_reduce(A[4 * i + 3]));
+                    }else{
+                        e[0] = acc_reduce(A[2 * i]);
+                        e[1] = acc_reduce(A[2 * i + 1]);
+                    }
+                }
+            }
+        }
+    }
+    return v;
+}
+
+ligeroProver_base::ligeroProver_base(const MultilinearPolynomial& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):rho_inv(rho_inv){
     size_t l = w.get_num_vars();
 
     // 2^l = a * b
-    a = 1ull << (l >> 1);       //floor(l/2)
-    b = a << (l & 1);           //ceil(l/2)
+    a = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / a;
+    poly_rows = a;
     M.resize(1ull << l, Goldilocks::zero());
     codelen = b * rho_inv;
     for(size_t i = 0; i < w.get_eval_table().size(); ++i){
         M[i] = w.eval_hypercube(i)[0];
     }
 
-    for(size_t i = 0; i < a; ++i){
-        std::vector<Goldilocks::Element> dataline(b);
-        for(size_t j = 0; j < b; ++j){
-            dataline[j] = M[i * b + j];
-        }
-        codewords.push_back(rsencode(dataline, rho_inv));
-    }
-    mt_t = MerkleTree_base(codewords);
+    auto codewords = std::make_shared<std::vector<Goldilocks::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
+    mt_t = MerkleTree_base(codewords, a, codelen, mt_config);
 }
 
 
-ligeroProver_base::ligeroProver_base(const std::vector<Goldilocks::Element>& w, const uint64_t& rho_inv):M(w), rho_inv(rho_inv){
+ligeroProver_base::ligeroProver_base(const std::vector<Goldilocks::Element>& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):M(w), rho_inv(rho_inv){
     // stevals = w.get_eval_table();
     size_t l = find_ceiling_log2(w.size());
 
     // 2^l = a * b
-    a = 1ull << (l >> 1);       //floor(l/2)
-    b = a << (l & 1);           //ceil(l/2)
+    a = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / a;
+    poly_rows = a;
     M.resize(1ull << l, Goldilocks::zero());
     codelen = b * rho_inv;
     for(size_t i = 0; i < w.size(); ++i){
         M[i] = w[i];
     }
-    for(size_t i = 0; i < a; ++i){
-        std::vector<Goldilocks::Element> dataline(b);
-        for(size_t j = 0; j < b; ++j){
-            dataline[j] = M[i * b + j];
-        }
-        codewords.push_back(rsencode(dataline, rho_inv));
-    }
-    mt_t = MerkleTree_base(codewords);
+    auto codewords = std::make_shared<std::vector<Goldilocks::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
+    mt_t = MerkleTree_base(codewords, a, codelen, mt_config);
 }
 
-ligeroProver_base::ligeroProver_base(const std::vector<uint64_t>& w, const uint64_t& rho_inv):rho_inv(rho_inv){
+ligeroProver_base::ligeroProver_base(const std::vector<uint64_t>& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):rho_inv(rho_inv){
     // stevals = w.get_eval_table();
     size_t l = find_ceiling_log2(w.size());
     // std::cout << l << '\n';
 
     // 2^l = a * b
-    a = 1ull << (l >> 1);       //floor(l/2)
-    b = a << (l & 1);           //ceil(l/2)
+    a = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / a;
+    poly_rows = a;
     set_timer("make matrix");
     M.resize(1ull << l, Goldilocks::zero());
     codelen = b * rho_inv;
@@ -80,120 +222,146 @@ ligeroProver_base::ligeroProver_base(const std::vector<uint64_t>& w, const uint6
         M[i] = Goldilocks::fromU64(w[i]);
     }
     set_timer("ntt");
-    pause_timer("ntt");
     alert("log-size of vector to be ntt-ed: " + std::to_string(b));
-    for(size_t i = 0; i < a; ++i){
-        std::vector<Goldilocks::Element> dataline(b);
-        for(size_t j = 0; j < b; ++j){
-            dataline[j] = M[i * b + j];
-        }
-        resume_timer("ntt");
-        codewords.push_back(rsencode(dataline, rho_inv));
-        pause_timer("ntt");
-    }
+    auto codewords = std::make_shared<std::vector<Goldilocks::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
     end_timer("ntt");
     end_timer("make matrix");
     set_timer("build merkle tree");
-    mt_t = MerkleTree_base(codewords);
+    mt_t = MerkleTree_base(codewords, a, codelen, mt_config);
     end_timer("build merkle tree");
 }
 
-std::vector<Goldilocks2::Element> ligeroProver_base::lincomb(const std::vector<Goldilocks2::Element>& r) const{
-    assert(r.size() == a);
-    // std::cout << r.size() << '\n' << a << '\n';
-    std::vector<Goldilocks2::Element> v(b, Goldilocks2::zero());
-    for(size_t j = 0; j < a; ++j){
-        Goldilocks2::Element tmp;
-        size_t offset = j * b;
-        for(size_t i = 0; i < b; ++i){
-            Goldilocks2::mul(tmp, r[j], M[offset + i]);
-            Goldilocks2::add(v[i], v[i], tmp);
+ligeroProver_base::ligeroProver_base(const std::vector<const std::vector<uint64_t>*>& ws, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):rho_inv(rho_inv){
+    assert(!ws.empty());
+    size_t l = find_ceiling_log2(ws[0]->size());
+
+    // 2^l = poly_rows * b for every polynomial, their matrices are stacked into a = ws.size() * poly_rows rows
+    poly_rows = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / poly_rows;
+    a = poly_rows * ws.size();
+    M.resize(a * b, Goldilocks::zero());
+    codelen = b * rho_inv;
+    for(size_t k = 0; k < ws.size(); ++k){
+        const std::vector<uint64_t>& w = *ws[k];
+        assert(w.size() == ws[0]->size());
+        for(size_t i = 0; i < w.size(); ++i){
+            M[(k << l) + i] = Goldilocks::fromU64(w[i]);
         }
     }
-    return v;
+    auto codewords = std::make_shared<std::vector<Goldilocks::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
+    mt_t = MerkleTree_base(codewords, a, codelen, mt_config);
 }
 
-std::vector<MerkleTree_base::MTPayload> ligeroProver_base::open_cols(const std::vector<size_t>& indexes) const{
-    std::vector<MerkleTree_base::MTPayload> payloads;
-    for(size_t e: indexes){
-        payloads.push_back(mt_t.MerkleOpen(e));
-    }
-    return payloads;
+std::vector<Goldilocks2::Element> ligeroProver_base::lincomb(const std::vector<Goldilocks2::Element>& r, const size_t& first_row) const{
+    return lincomb(std::vector<std::vector<Goldilocks2::Element>>{r}, first_row)[0];
+}
+
+std::vector<std::vector<Goldilocks2::Element>> ligeroProver_base::lincomb(const std::vector<std::vector<Goldilocks2::Element>>& rs, const size_t& first_row) const{
+    assert(!rs.empty() && first_row + rs[0].size() <= a);
+    return lincomb_impl(M.data() + first_row * b, rs[0].size(), b, rs);
+}
+
+MerkleTree_base::MTMultiPayload ligeroProver_base::open_cols(const std::vector<size_t>& indexes) const{
+    return mt_t.MerkleMultiOpen(indexes);
 }
 
 ligeropcs_base ligeroProver_base::commit() const{
-    return {mt_t.MerkleCommit(), std::make_shared<ligeroProver_base>(*this), a, b};
+    assert(a == poly_rows);
+    return {mt_t.MerkleCommit(), shared_from_this(), a, b, 0};
+}
+
+std::vector<ligeropcs_base> ligeroProver_base::commit_all() const{
+    std::vector<ligeropcs_base> pcs;
+    const MerkleDef::MTCommitment mtcommit = mt_t.MerkleCommit();
+    for(size_t row = 0; row < a; row += poly_rows){
+        pcs.push_back({mtcommit, shared_from_this(), poly_rows, b, row});
+    }
+    return pcs;
 }
 
 
 
-ligeroProver_ext::ligeroProver_ext(const MultilinearPolynomial& w, const uint64_t& rho_inv):rho_inv(rho_inv){
+ligeroProver_ext::ligeroProver_ext(const MultilinearPolynomial& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):rho_inv(rho_inv){
     // evals = w.get_eval_table();
     // std::vector<Goldilocks2::Element> evals = w.get_eval_table();
     size_t l = w.get_num_vars();
     M.resize(1ull << l, Goldilocks2::zero());
     // 2^l = a * b
-    a = 1ull << (l >> 1);       //floor(l/2)
-    b = a << (l & 1);           //ceil(l/2)
+    a = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / a;
+    poly_rows = a;
     codelen = b * rho_inv;
     for(size_t i = 0; i < w.get_eval_table().size(); ++i){
         M[i] = w.eval_hypercube(i);
     }
-    for(size_t i = 0; i < a; ++i){
-        std::vector<Goldilocks2::Element> dataline(b);
-        for(size_t j = 0; j < b; ++j){
-            dataline[j] = M[i * b + j];
-        }
-        codewords.push_back(rsencode(dataline, rho_inv));
-    }
-    mt_t = MerkleTree_ext(codewords);
+    auto codewords = std::make_shared<std::vector<Goldilocks2::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
+    mt_t = MerkleTree_ext(codewords, a, codelen, mt_config);
 }
 
-ligeroProver_ext::ligeroProver_ext(const std::vector<Goldilocks2::Element>& w, const uint64_t& rho_inv):M(w), rho_inv(rho_inv){
+ligeroProver_ext::ligeroProver_ext(const std::vector<Goldilocks2::Element>& w, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):M(w), rho_inv(rho_inv){
     size_t l = find_ceiling_log2(w.size());
     M.resize(1ull << l, Goldilocks2::zero());
     // 2^l = a * b
-    a = 1ull << (l >> 1);       //floor(l/2)
-    b = a << (l & 1);           //ceil(l/2)
+    a = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / a;
+    poly_rows = a;
     codelen = b * rho_inv;
     for(size_t i = 0; i < w.size(); ++i){
         M[i] = w[i];
     }
-    for(size_t i = 0; i < a; ++i){
-        std::vector<Goldilocks2::Element> dataline(b);
-        for(size_t j = 0; j < b; ++j){
-            dataline[j] = M[i * b + j];
-        }
-        codewords.push_back(rsencode(dataline, rho_inv));
-    }
-    mt_t = MerkleTree_ext(codewords);
+    auto codewords = std::make_shared<std::vector<Goldilocks2::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
+    mt_t = MerkleTree_ext(codewords, a, codelen, mt_config);
 }
 
-std::vector<Goldilocks2::Element> ligeroProver_ext::lincomb(const std::vector<Goldilocks2::Element>& r) const{
-    assert(r.size() == a);
-    // std::cout << r.size() << '\n' << a << '\n';
-    std::vector<Goldilocks2::Element> v(b, Goldilocks2::zero());
-    for(size_t j = 0; j < a; ++j){
-        Goldilocks2::Element tmp;
-        size_t offset = j * b;
-        for(size_t i = 0; i < b; ++i){
-            Goldilocks2::mul(tmp, r[j], M[offset + i]);
-            Goldilocks2::add(v[i], v[i], tmp);
-        }
+ligeroProver_ext::ligeroProver_ext(const std::vector<const std::vector<Goldilocks2::Element>*>& ws, const uint64_t& rho_inv, const MerkleDef::MTConfig& mt_config, const size_t& log_rows):rho_inv(rho_inv){
+    assert(!ws.empty());
+    size_t l = find_ceiling_log2(ws[0]->size());
+
+    // 2^l = poly_rows * b for every polynomial, their matrices are stacked into a = ws.size() * poly_rows rows
+    poly_rows = 1ull << matrix_log_rows(l, log_rows);
+    b = (1ull << l) / poly_rows;
+    a = poly_rows * ws.size();
+    M.resize(a * b, Goldilocks2::zero());
+    codelen = b * rho_inv;
+    for(size_t k = 0; k < ws.size(); ++k){
+        const std::vector<Goldilocks2::Element>& w = *ws[k];
+        assert(w.size() == ws[0]->size());
+        std::copy(w.begin(), w.end(), M.begin() + (k << l));
     }
-    return v;
+    auto codewords = std::make_shared<std::vector<Goldilocks2::Element>>(a * codelen);
+    rsencode_matrix(M, a, b, rho_inv, *codewords);
+    mt_t = MerkleTree_ext(codewords, a, codelen, mt_config);
 }
 
-std::vector<MerkleTree_ext::MTPayload> ligeroProver_ext::open_cols(const std::vector<size_t>& indexes) const{
-    std::vector<MerkleTree_ext::MTPayload> payloads;
-    for(size_t e: indexes){
-        payloads.push_back(mt_t.MerkleOpen(e));
-    }
-    return payloads;
+std::vector<Goldilocks2::Element> ligeroProver_ext::lincomb(const std::vector<Goldilocks2::Element>& r, const size_t& first_row) const{
+    return lincomb(std::vector<std::vector<Goldilocks2::Element>>{r}, first_row)[0];
+}
+
+std::vector<std::vector<Goldilocks2::Element>> ligeroProver_ext::lincomb(const std::vector<std::vector<Goldilocks2::Element>>& rs, const size_t& first_row) const{
+    assert(!rs.empty() && first_row + rs[0].size() <= a);
+    return lincomb_impl(M.data() + first_row * b, rs[0].size(), b, rs);
+}
+
+MerkleTree_ext::MTMultiPayload ligeroProver_ext::open_cols(const std::vector<size_t>& indexes) const{
+    return mt_t.MerkleMultiOpen(indexes);
 }
 
 ligeropcs_ext ligeroProver_ext::commit() const{
-    return {mt_t.MerkleCommit(), std::make_shared<ligeroProver_ext>(*this), a, b};
+    assert(a == poly_rows);
+    return {mt_t.MerkleCommit(), shared_from_this(), a, b, 0};
+}
+
+std::vector<ligeropcs_ext> ligeroProver_ext::commit_all() const{
+    std::vector<ligeropcs_ext> pcs;
+    const MerkleDef::MTCommitment mtcommit = mt_t.MerkleCommit();
+    for(size_t row = 0; row < a; row += poly_rows){
+        pcs.push_back({mtcommit, shared_from_this(), poly_rows, b, row});
+    }
+    return pcs;
 }
 
 
@@ -221,78 +389,117 @@ std::vector<size_t> ligeroVerifier::randindexes(const uint64_t& n, const size_t&
     for (uint64_t i = 0; i < n; ++i) {
         rands.push_back(_dist(_gen));
     }
+    // a repeated index is opened and checked once
+    std::sort(rands.begin(), rands.end());
+    rands.erase(std::unique(rands.begin(), rands.end()), rands.end());
     return rands;
 }
 
+// every opened column is a whole column of the committed matrix, checked before it is hashed or read
+template <typename Payload>
+static bool columns_have_rows(const Payload& opening, const size_t& num_rows){
+    for(const auto& col: opening.columns){
+        if(col.size() != num_rows) return false;
+    }
+    return true;
+}
 
-bool ligeroVerifier::check_lincomb(const ligeropcs_base& pcs, const std::vector<Goldilocks2::Element>& r , const std::vector<Goldilocks2::Element>& comb, const size_t& t){
+// r . (rows [offset, offset + r.size()) of an opened column)
+template <typename Column>
+static Goldilocks2::Element column_dot(const std::vector<Goldilocks2::Element>& r, const Column& col, const size_t& offset){
+    Goldilocks2::Element entry = Goldilocks2::zero();
+    Goldilocks2::Element tmp;
+    for(size_t i = 0; i < r.size(); ++i){
+        Goldilocks2::mul(tmp, r[i], col[offset + i]);
+        Goldilocks2::add(entry, entry, tmp);
+    }
+    return entry;
+}
+
+// one query round for all combinations: the same columns are opened once and checked against every comb
+template <typename Tree, typename PCS>
+bool ligeroVerifier::check_lincombs(const PCS& pcs, const std::vector<std::vector<Goldilocks2::Element>>& rs, const std::vector<std::vector<Goldilocks2::Element>>& combs, const size_t& t){
     const auto &prover = *pcs.prover;
-    std::vector<size_t> indexes = randindexes(t, std::ceil(pcs.num_cols * prover.rho_inv));
-    // std::vector<size_t> indexes = {7, 7, 7, 7, 7};
+    std::vector<size_t> indexes = randindexes(t, prover.codelen);
+
+    auto opening = prover.open_cols(indexes);
+    // check if the openings are right and are the queried columns
+    if(opening.indexes.size() != indexes.size() || !columns_have_rows(opening, prover.matrix_rows()) || !Tree::MerkleMultiVerify(pcs.mtcommit, opening)) return false;
+    const size_t leaf_offset = 1ull << find_ceiling_log2(prover.codelen);
 
-    auto openings = prover.open_cols(indexes);
-    for(auto opening: openings){
-        // check if this opening is right
-        if(!MerkleTree_base::MerkleVerify(pcs.mthash, opening)) return false;
+    for(size_t k = 0; k < indexes.size(); ++k){
+        if(opening.indexes[k] != leaf_offset + indexes[k]) return false;
     }
 
-    for(size_t k = 0;k < indexes.size(); ++k){
-        size_t idx = indexes[k];
-        // check if this entry is correctly computed
-        Goldilocks2::Element entry = Goldilocks2::zero();
-        Goldilocks2::Element tmp;
-        for(size_t i = 0;i < pcs.num_rows; ++i){
-            Goldilocks2::mul(tmp, r[i], openings[k].column[i]);
-            Goldilocks2::add(entry, entry, tmp);
+    // check if every entry is correctly computed, for every combination; the columns are independent
+    bool ok = true;
+    #pragma omp parallel for schedule(static) reduction(&&: ok) if(indexes.size() * pcs.num_rows >= LIGERO_VERIFY_PARALLEL_THRESHOLD)
+    for(size_t k = 0; k < indexes.size(); ++k){
+        for(size_t q = 0; q < rs.size(); ++q){
+            ok = ok && column_dot(rs[q], opening.columns[k], pcs.row_offset) == combs[q][indexes[k]];
         }
-        if(entry != comb[idx]) return false;
     }
+    return ok;
+}
 
-    return true;
+bool ligeroVerifier::check_lincomb(const ligeropcs_base& pcs, const std::vector<Goldilocks2::Element>& r , const std::vector<Goldilocks2::Element>& comb, const size_t& t){
+    return check_lincombs<MerkleTree_base>(pcs, {r}, {comb}, t);
 }
 
 bool ligeroVerifier::check_lincomb(const ligeropcs_ext& pcs, const std::vector<Goldilocks2::Element>& r , const std::vector<Goldilocks2::Element>& comb, const size_t& t){
-    const auto &prover = *pcs.prover;
-    std::vector<size_t> indexes = randindexes(t, pcs.num_cols * prover.rho_inv);
-    // std::vector<size_t> indexes = {7, 7, 7, 7, 7};
-
-    auto openings = prover.open_cols(indexes);
-    for(auto opening: openings){
-        // check if this opening is right
-        if(!MerkleTree_ext::MerkleVerify(pcs.mthash, opening)) return false;
-    }
+    return check_lincombs<MerkleTree_ext>(pcs, {r}, {comb}, t);
+}
 
-    for(size_t k = 0;k < indexes.size(); ++k){
-        size_t idx = indexes[k];
-        // check if this entry is correctly computed
-        Goldilocks2::Element entry = Goldilocks2::zero();
-        Goldilocks2::Element tmp;
-        for(size_t i = 0;i < pcs.num_rows; ++i){
-            Goldilocks2::mul(tmp, r[i], openings[k].column[i]);
-            Goldilocks2::add(entry, entry, tmp);
+// commitments of one shape share the query round: r_i for every one of them, then sum_i r_i^T M_i is encoded once
+// and checked on one set of columns, opened once per merkle tree
+template <typename Tree, typename PCS>
+bool ligeroVerifier::check_commits(const std::vector<PCS>& pcs, const size_t& sec_param){
+    std::vector<bool> done(pcs.size(), false);
+    for(size_t first = 0; first < pcs.size(); ++first){
+        if(done[first]) continue;
+        std::vector<PCS> group;
+        for(size_t i = first; i < pcs.size(); ++i){
+            if(!done[i] && pcs[i].num_rows == pcs[first].num_rows && pcs[i].num_cols == pcs[first].num_cols && pcs[i].prover->rho_inv == pcs[first].prover->rho_inv){
+                group.push_back(pcs[i]);
+                done[i] = true;
+            }
+        }
+        const auto& prover = *group[0].prover;
+        std::vector<std::vector<Goldilocks2::Element>> rs;
+        std::vector<Goldilocks2::Element> v(group[0].num_cols, Goldilocks2::zero());
+        for(const auto& pc: group){
+            rs.push_back(randvec(pc.num_rows));
+            std::vector<Goldilocks2::Element> vi = pc.prover->lincomb(rs.back(), pc.row_offset);
+            for(size_t i = 0; i < v.size(); ++i){
+                Goldilocks2::add(v[i], v[i], vi[i]);
+            }
+        }
+        std::vector<Goldilocks2::Element> w = rsencode(v, prover.rho_inv);
+        size_t t = calculate_t(sec_param, prover.rho_inv, prover.codelen, FIELD_BITS);
+        std::vector<size_t> indexes = randindexes(t, prover.codelen);
+        std::vector<Goldilocks2::Element> entries(indexes.size(), Goldilocks2::zero());
+        if(!query_columns<Tree>(group, indexes, rs, entries)) return false;
+        for(size_t k = 0; k < indexes.size(); ++k){
+            if(entries[k] != w[indexes[k]]) return false;
         }
-        if(entry != comb[idx]) return false;
     }
-
     return true;
 }
 
 bool ligeroVerifier::check_commit(const ligeropcs_base& pcs, const size_t& sec_param){
-    const auto& prover = *pcs.prover; 
-    std::vector<Goldilocks2::Element> r = randvec(pcs.num_rows);
-    std::vector<Goldilocks2::Element> v = prover.lincomb(r);
-    std::vector<Goldilocks2::Element> w = rsencode(v, prover.rho_inv);
-    size_t t = calculate_t(sec_param, prover.rho_inv, prover.codelen, FIELD_BITS);
-    return check_lincomb(pcs, r, w, t);
+    return check_commits<MerkleTree_base>(std::vector<ligeropcs_base>{pcs}, sec_param);
 }
 
 bool ligeroVerifier::check_commit(const ligeropcs_ext& pcs, const size_t& sec_param){
-    const auto& prover = *pcs.prover; 
-    std::vector<Goldilocks2::Element> r = randvec(pcs.num_rows);
-    std::vector<Goldilocks2::Element> v = prover.lincomb(r);
-    std::vector<Goldilocks2::Element> w = rsencode(v, prover.rho_inv);
-    size_t t = calculate_t(sec_param, prover.rho_inv, prover.codelen, FIELD_BITS);
-    return check_lincomb(pcs, r, w, t);
+    return check_commits<MerkleTree_ext>(std::vector<ligeropcs_ext>{pcs}, sec_param);
+}
+
+bool ligeroVerifier::check_commit(const std::vector<ligeropcs_base>& pcs, const size_t& sec_param){
+    return check_commits<MerkleTree_base>(pcs, sec_param);
+}
+
+bool ligeroVerifier::check_commit(const std::vector<ligeropcs_ext>& pcs, const size_t& sec_param){
+    return check_commits<MerkleTree_ext>(pcs, sec_param);
 }
 
 // maybe can be moved to util?
@@ -327,15 +534,148 @@ Goldilocks2::Element dot_product(const std::vector<Goldilocks2::Element> &b, con
     return res;
 }
 
+// the proximity test (random r) and the evaluation at every z share one prover sweep (lincomb of all R at once) and one query round
+template <typename Tree, typename PCS>
+bool ligeroVerifier::open_many(const PCS& pcs, const std::vector<std::vector<Goldilocks2::Element>>& zs, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals){
+    const auto &prover = *pcs.prover;
+    std::vector<std::vector<Goldilocks2::Element>> rs = {randvec(pcs.num_rows)};
+    std::vector<std::vector<Goldilocks2::Element>> Ls;
+    for(const auto& z: zs){
+        std::array<std::vector<Goldilocks2::Element>, 2> lr = calculate_lr(__builtin_ctzll(pcs.num_rows), z);
+        Ls.push_back(std::move(lr[0]));
+        rs.push_back(std::move(lr[1]));
+    }
+    std::vector<std::vector<Goldilocks2::Element>> vs = prover.lincomb(rs, pcs.row_offset);
+    std::vector<std::vector<Goldilocks2::Element>> ws;
+    ws.reserve(vs.size());
+    for(const auto& v: vs){
+        ws.push_back(rsencode(v, prover.rho_inv));
+    }
+    size_t t = calculate_t(sec_param, prover.rho_inv, prover.codelen, FIELD_BITS);
+    if(!check_lincombs<Tree>(pcs, rs, ws, t)) return false;
+
+    evals.resize(zs.size());
+    for(size_t q = 0; q < zs.size(); ++q){
+        evals[q] = dot_product(vs[q + 1], Ls[q]);
+    }
+    return true;
+}
+
+bool ligeroVerifier::open(const ligeropcs_base& pcs, const std::vector<std::vector<Goldilocks2::Element>>& zs, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals){
+    return open_many<MerkleTree_base>(pcs, zs, sec_param, evals);
+}
+
+bool ligeroVerifier::open(const ligeropcs_ext& pcs, const std::vector<std::vector<Goldilocks2::Element>>& zs, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals){
+    return open_many<MerkleTree_ext>(pcs, zs, sec_param, evals);
+}
+
+// add rs[q] . (rows of pcs[q] in column k) to entries[k] for all q and the columns at indexes (sorted, distinct)
+// the columns are opened and verified once per tree: commitments batched into one tree (same prover and same
+// merkle commitment) share that opening
+template <typename Tree, typename PCS>
+bool ligeroVerifier::query_columns(const std::vector<PCS>& pcs, const std::vector<size_t>& indexes, const std::vector<std::vector<Goldilocks2::Element>>& rs, std::vector<Goldilocks2::Element>& entries){
+    // index of the commitment the opening was verified against, and the opening
+    std::vector<std::pair<size_t, typename Tree::MTMultiPayload>> openings;
+    auto same_tree = [&](const PCS& x, const PCS& y){
+        return x.prover == y.prover && x.mtcommit.cap == y.mtcommit.cap && x.mtcommit.config.log_arity == y.mtcommit.config.log_arity &&
+            x.mtcommit.config.cap_height == y.mtcommit.config.cap_height && x.mtcommit.config.hash == y.mtcommit.config.hash;
+    };
+    for(size_t q = 0; q < pcs.size(); ++q){
+        const auto &prover = *pcs[q].prover;
+        auto it = std::find_if(openings.begin(), openings.end(), [&](const auto& o){return same_tree(pcs[o.first], pcs[q]);});
+        if(it == openings.end()){
+            auto opening = prover.open_cols(indexes);
+            if(opening.indexes.size() != indexes.size() || !columns_have_rows(opening, prover.matrix_rows()) ||
+                !Tree::MerkleMultiVerify(pcs[q].mtcommit, opening)) return false;
+            const size_t leaf_offset = 1ull << find_ceiling_log2(prover.codelen);
+            for(size_t k = 0; k < indexes.size(); ++k){
+                if(opening.indexes[k] != leaf_offset + indexes[k]) return false;
+            }
+            openings.emplace_back(q, std::move(opening));
+            it = openings.end() - 1;
+        }
+        const auto& columns = it->second.columns;
+        #pragma omp parallel for schedule(static) if(indexes.size() * pcs[q].num_rows >= LIGERO_VERIFY_PARALLEL_THRESHOLD)
+        for(size_t k = 0; k < indexes.size(); ++k){
+            Goldilocks2::add(entries[k], entries[k], column_dot(rs[q], columns[k], pcs[q].row_offset));
+        }
+    }
+    return true;
+}
+
+bool ligeroVerifier::open(const std::vector<ligeropcs_base>& pcs_base, const std::vector<ligeropcs_ext>& pcs_ext, const std::vector<Goldilocks2::Element> &z, const size_t& sec_param, std::vector<Goldilocks2::Element>& evals){
+    const size_t n = pcs_base.size() + pcs_ext.size();
+    if(n == 0) return true;
+    // every commitment has the matrix shape and code of the first one
+    const size_t num_rows = pcs_base.empty() ? pcs_ext[0].num_rows : pcs_base[0].num_rows;
+    const size_t num_cols = pcs_base.empty() ? pcs_ext[0].num_cols : pcs_base[0].num_cols;
+    const uint64_t rho_inv = pcs_base.empty() ? pcs_ext[0].prover->rho_inv : pcs_base[0].prover->rho_inv;
+    const size_t codelen = pcs_base.empty() ? pcs_ext[0].prover->codelen : pcs_base[0].prover->codelen;
+    for(const auto& pcs: pcs_base){
+        if(pcs.num_rows != num_rows || pcs.num_cols != num_cols || pcs.prover->rho_inv != rho_inv) return false;
+    }
+    for(const auto& pcs: pcs_ext){
+        if(pcs.num_rows != num_rows || pcs.num_cols != num_cols || pcs.prover->rho_inv != rho_inv) return false;
+    }
+
+    // one pair of tensors for all
+    std::array<std::vector<Goldilocks2::Element>, 2> lr = calculate_lr(__builtin_ctzll(num_rows), z);
+    const std::vector<Goldilocks2::Element>& L = lr[0];
+    const std::vector<Goldilocks2::Element>& R = lr[1];
+
+    // v'_i of every commitment, then their random combination sum alpha_i v'_i which is encoded once
+    std::vector<std::vector<Goldilocks2::Element>> vs;
+    vs.reserve(n);
+    for(const auto& pcs: pcs_base){
+        vs.push_back(pcs.prover->lincomb(R, pcs.row_offset));
+    }
+    for(const auto& pcs: pcs_ext){
+        vs.push_back(pcs.prover->lincomb(R, pcs.row_offset));
+    }
+    std::vector<Goldilocks2::Element> alpha = randvec(n);
+    std::vector<Goldilocks2::Element> v(vs[0].size(), Goldilocks2::zero());
+    for(size_t q = 0; q < n; ++q){
+        Goldilocks2::Element tmp;
+        for(size_t i = 0; i < v.size(); ++i){
+            Goldilocks2::mul(tmp, alpha[q], vs[q][i]);
+            Goldilocks2::add(v[i], v[i], tmp);
+        }
+    }
+    std::vector<Goldilocks2::Element> w = rsencode(v, rho_inv);
+
+    // one set of columns, opened in every commitment
+    size_t t = calculate_t(sec_param, rho_inv, codelen, FIELD_BITS);
+    std::vector<size_t> indexes = randindexes(t, codelen);
+    // alpha_i R for every commitment
+    std::vector<std::vector<Goldilocks2::Element>> Rs(n, R);
+    for(size_t q = 0; q < n; ++q){
+        for(auto& e: Rs[q]){
+            Goldilocks2::mul(e, alpha[q], e);
+        }
+    }
+    std::vector<Goldilocks2::Element> entries(indexes.size(), Goldilocks2::zero());
+    if(!query_columns<MerkleTree_base>(pcs_base, indexes, {Rs.begin(), Rs.begin() + pcs_base.size()}, entries)) return false;
+    if(!query_columns<MerkleTree_ext>(pcs_ext, indexes, {Rs.begin() + pcs_base.size(), Rs.end()}, entries)) return false;
+    for(size_t k = 0; k < indexes.size(); ++k){
+        if(entries[k] != w[indexes[k]]) return false;
+    }
+
+    evals.resize(n);
+    for(size_t q = 0; q < n; ++q){
+        evals[q] = dot_product(vs[q], L);
+    }
+    return true;
+}
+
 Goldilocks2::Element ligeroVerifier::open(const ligeropcs_base& pcs, const std::vector<Goldilocks2::Element> &z,  const size_t& sec_param){
-    std::array<std::vector<Goldilocks2::Element>, 2> lr = calculate_lr(z.size(), z);
+    std::array<std::vector<Goldilocks2::Element>, 2> lr = calculate_lr(__builtin_ctzll(pcs.num_rows), z);
     
     std::vector<Goldilocks2::Element> L = lr[0];
     std::vector<Goldilocks2::Element> R = lr[1];
 
     const auto &prover = *pcs.prover;
     // v_prime for v', idealy we have E(v') = w', w' = R dot uhat
-    std::vector<Goldilocks2::Element> v_prime = prover.lincomb(R);
+    std::vector<Goldilocks2::Element> v_prime = prover.lincomb(R, pcs.row_offset);
 
     std::vector<Goldilocks2::Element> w_prime = rsencode(v_prime, prover.rho_inv);
     size_t t = calculate_t(sec_param, prover.rho_inv, prover.codelen, FIELD_BITS);
@@ -345,14 +685,14 @@ Goldilocks2::Element ligeroVerifier::open(const ligeropcs_base& pcs, const std::
 }
 
 Goldilocks2::Element ligeroVerifier::open(const ligeropcs_ext& pcs, const std::vector<Goldilocks2::Element> &z,  const size_t& sec_param){
-    std::array<std::vector<Goldilocks2::Element>, 2> lr = calculate_lr(z.size(), z);
+    std::array<std::vector<Goldilocks2::Element>, 2> lr = calculate_lr(__builtin_ctzll(pcs.num_rows), z);
     
     std::vector<Goldilocks2::Element> L = lr[0];
     std::vector<Goldilocks2::Element> R = lr[1];
 
     const auto &prover = *pcs.prover;
     // v_prime for v', idealy we have E(v') = w', w' = R dot uhat
-    std::vector<Goldilocks2::Element> v_prime = prover.lincomb(R);
+    std::vector<Goldilocks2::Element> v_prime = prover.lincomb(R, pcs.row_offset);
 
     std::vector<Goldilocks2::Element> w_prime = rsencode(v_prime, prover.rho_inv);
     size_t t = calculate_t(sec_param, prover.rho_inv, prover.codelen, FIELD_BITS);
@@ -361,17 +701,15 @@ Goldilocks2::Element ligeroVerifier::open(const ligeropcs_ext& pcs, const std::v
     return dot_product(v_prime, L);
 }
 
-std::array<std::vector<Goldilocks2::Element>, 2> ligeroVerifier::calculate_lr(const size_t& num_var, const std::vector<Goldilocks2::Element> &z){
-    //different from a,b in prover, a, b here are the log of each
-    size_t a = num_var >> 1, b = a + (num_var & 1);
-
-    // high bit of z
-    std::vector<Goldilocks2::Element> zh(z.begin(), z.begin() + a);
-    // low bits of z
-    std::vector<Goldilocks2::Element> zl(z.begin() + a, z.end());
+std::array<std::vector<Goldilocks2::Element>, 2> ligeroVerifier::calculate_lr(const size_t& log_rows, const std::vector<Goldilocks2::Element> &z){
+    assert(log_rows <= z.size());
+    // high bits of z select the row
+    std::vector<Goldilocks2::Element> zh(z.begin(), z.begin() + log_rows);
+    // low bits of z select the column
+    std::vector<Goldilocks2::Element> zl(z.begin() + log_rows, z.end());
 
-    std::vector<Goldilocks2::Element> L = eq(b, zl).get_eval_table();
-    std::vector<Goldilocks2::Element> R = eq(a, zh).get_eval_table();
+    std::vector<Goldilocks2::Element> L = eq(zl.size(), zl).get_eval_table();
+    std::vector<Goldilocks2::Element> R = eq(log_rows, zh).get_eval_table();
 
     return {L, R};
 }
@@ -394,3 +732,36 @@ size_t ligeroVerifier::calculate_t(
     size_t t = static_cast<size_t>(std::ceil(numerator / denominator));
     return std::min(t, codeword_len);
 }
+
+size_t ligero_log_rows(const size_t& l, const uint64_t& rho_inv, const size_t& sec_param, const LigeroTarget& target){
+    // rough costs in base field multiplications: one element absorbed by a leaf hash, one node hash, one extension multiplication,
+    // and one element (or a quarter of a digest) of the proof sent to the verifier
+    constexpr double leaf_cost = 6, node_cost = 100, ext_mul_cost = 4, proof_cost = 8;
+    // the other side still counts, so that neither degenerates into a single row or column
+    const double prover_weight = target == LigeroTarget::Verifier ? 0.25 : 1;
+    const double verifier_weight = target == LigeroTarget::Prover ? 0.25 : 1;
+
+    size_t best = l >> 1;
+    double best_cost = INFINITY;
+    for(size_t log_rows = 0; log_rows <= l; ++log_rows){
+        const double rows = std::ldexp(1.0, log_rows), cols = std::ldexp(1.0, l - log_rows);
+        const size_t codelen = (1ull << (l - log_rows)) * rho_inv;
+        const double log_codelen = std::max(1.0, std::log2(static_cast<double>(codelen)));
+        // calculate_t cannot reach sec_param with codewords this long
+        if(log_codelen + sec_param >= (FIELD_BITS) - 1) continue;
+        const double t = ligeroVerifier::calculate_t(sec_param, rho_inv, codelen, FIELD_BITS);
+        // every column would be opened
+        if(t >= codelen) continue;
+        // an NTT of length codelen per row, every codeword element hashed into a leaf, about one node per leaf
+        const double prover = rows * codelen * log_codelen + leaf_cost * rows * codelen + node_cost * codelen;
+        // v' (cols extension elements) encoded, t columns of rows elements hashed and combined with r, their paths, the tensors
+        const double verifier = 2 * codelen * log_codelen + t * rows * (leaf_cost + ext_mul_cost) + node_cost * t * log_codelen
+            + ext_mul_cost * (rows + cols) + proof_cost * (cols + t * rows + 4 * t * log_codelen);
+        const double cost = prover_weight * prover + verifier_weight * verifier;
+        if(cost < best_cost){
+            best_cost = cost;
+            best = log_rows;
+        }
+    }
+    return best;
+}
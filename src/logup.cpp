@@ -48,8 +48,8 @@ void LogupProver::calculate_gh(const Goldilocks2::Element& gamma, const Goldiloc
         h[i] = {c[i], Goldilocks::zero()};
     }
     g.resize(f1.size(), Goldilocks2::one());
-    denomg.resize(g.size());
-    denomh.resize(h.size());
+    // the denominators are only needed here, the product sumchecks recompute them from f and t
+    table_ext denomg(g.size()), denomh(h.size());
     table_ext inv(std::max(g.size(), h.size())); // store inverse of denomg and denomh
 
     for (size_t i = 0;i < f1.size(); ++i){
@@ -85,27 +85,41 @@ void LogupProver::calculate_gh(const Goldilocks2::Element& gamma, const Goldiloc
 
 std::array<LogupDef::pcs_base, 4> LogupProver::commit_ft(const uint64_t& rho_inv){
     set_timer("commit to f1, f2, f3, f4");
-    ligeroProver_base 
-                prf1(f1, rho_inv),
-                prf2(f2, rho_inv),
-                prt1(t1, rho_inv),
-                prt2(t2, rho_inv);
+    // tables of the same size share one matrix and one merkle tree
+    std::vector<LogupDef::pcs_base> f, t;
+    if(f1.size() == t1.size()){
+        f = std::make_shared<ligeroProver_base>(std::vector<const table_base*>{&f1, &f2, &t1, &t2}, rho_inv)->commit_all();
+        t = {f[2], f[3]};
+    }else{
+        f = std::make_shared<ligeroProver_base>(std::vector<const table_base*>{&f1, &f2}, rho_inv)->commit_all();
+        t = std::make_shared<ligeroProver_base>(std::vector<const table_base*>{&t1, &t2}, rho_inv)->commit_all();
+    }
+    std::array<LogupDef::pcs_base, 4> pcs = {f[0], f[1], t[0], t[1]};
     end_timer("commit to f1, f2, f3, f4");
-    return {prf1.commit(), prf2.commit(), prt1.commit(), prt2.commit()};
+    return pcs;
 }
 
 LogupDef::pcs_base LogupProver::commit_c(const uint64_t& rho_inv){
     set_timer("commit to c");
-    ligeroProver_base pr(c, rho_inv);
+    LogupDef::pcs_base pcs = std::make_shared<ligeroProver_base>(c, rho_inv)->commit();
     end_timer("commit to c");
-    return pr.commit();
+    return pcs;
 }
 
 std::array<LogupDef::pcs_ext, 2> LogupProver::commit_gh(const uint64_t& rho_inv){
     set_timer("commit to g, h");
-    ligeroProver_ext prg(g, rho_inv), prh(h, rho_inv);
+    std::array<LogupDef::pcs_ext, 2> pcs;
+    if(g.size() == h.size()){
+        auto gh = std::make_shared<ligeroProver_ext>(std::vector<const table_ext*>{&g, &h}, rho_inv)->commit_all();
+        pcs = {gh[0], gh[1]};
+    }else{
+        pcs = {
+            std::make_shared<ligeroProver_ext>(g, rho_inv)->commit(),
+            std::make_shared<ligeroProver_ext>(h, rho_inv)->commit()
+        };
+    }
     end_timer("commit to g, h");
-    return {prg.commit(), prh.commit()};
+    return pcs;
 }
 
 
@@ -117,17 +131,23 @@ std::array<sProver, 2> LogupProver::firstProvers(){
     return {sprg, sprh};
 }
 
-std::array<pProver, 2> LogupProver::secondProvers(const std::vector<Goldilocks2::Element>& rg, const std::vector<Goldilocks2::Element>& rh){
+static lProver::table_base to_base(const LogupProver::table_base& t){
+    lProver::table_base res(t.size());
+    for(size_t i = 0; i < t.size(); ++i){
+        res[i] = Goldilocks::fromU64(t[i]);
+    }
+    return res;
+}
+
+std::array<lProver, 2> LogupProver::secondProvers(const std::vector<Goldilocks2::Element>& rg, const std::vector<Goldilocks2::Element>& rh,
+                                                  const Goldilocks2::Element& gamma, const Goldilocks2::Element& lambda){
     assert((1ull << rg.size()) == g.size());
     assert((1ull << rh.size()) == h.size());
     set_timer("initialize sumcheck provers for the product sumcheck");
-    MultilinearPolynomial polydenomg(denomg);
-    MultilinearPolynomial polydenomh(denomh);
-    MultilinearPolynomial eqg = eq((*polyg).get_num_vars(), rg);
-    MultilinearPolynomial eqh = eq((*polyh).get_num_vars(), rh);
-    pProver prg(eqg, *polyg, polydenomg);
-    pProver prh(eqh, *polyh, polydenomh);
-    std::array<pProver, 2> provers = {prg, prh};
+    // f and t stay in the base field until the first fold, eq(rg, .) and eq(rh, .) are not tabulated
+    lProver prg({to_base(f1), to_base(f2)}, {*polyg}, {gamma, lambda}, rg);
+    lProver prh({to_base(t1), to_base(t2)}, {*polyh}, {gamma, lambda}, rh);
+    std::array<lProver, 2> provers = {prg, prh};
     end_timer("initialize sumcheck provers for the product sumcheck");
     return provers;
 }
@@ -139,17 +159,13 @@ std::uniform_int_distribution<uint64_t> LogupVerifier::dist(0, Goldilocks2::p -
 bool LogupVerifier::execute_logup(LogupProver& lpr, const uint64_t& rho_inv, const size_t& sec_param){
     auto ft = lpr.commit_ft(rho_inv);
     set_timer("check commitment of f, t");
-    for(auto pc: ft){
-        if(!ligeroVerifier::check_commit(pc, sec_param)) return false;
-    }
+    if(!ligeroVerifier::check_commit(std::vector<LogupDef::pcs_base>(ft.begin(), ft.end()), sec_param)) return false;
     end_timer("check commitment of f, t");
     // alert("f,t commited");
 
 
+    // c is only opened once, at rh, its proximity test runs together with that opening
     auto c = lpr.commit_c(rho_inv);
-    set_timer("check commitment of c");
-    if(!ligeroVerifier::check_commit(c, sec_param)) return false;
-    end_timer("check commitment of c");
     // alert("c commited");
 
     Goldilocks2::Element gamma = randnum();
@@ -157,9 +173,7 @@ bool LogupVerifier::execute_logup(LogupProver& lpr, const uint64_t& rho_inv, con
     lpr.calculate_gh(gamma, lambda);
     auto gh = lpr.commit_gh(rho_inv);
     set_timer("check commitment of g, h");
-    for(auto pc: gh){
-        if(!ligeroVerifier::check_commit(pc, sec_param)) return false;
-    }
+    if(!ligeroVerifier::check_commit(std::vector<LogupDef::pcs_ext>(gh.begin(), gh.end()), sec_param)) return false;
     end_timer("check commitment of g, h");
     // alert("g,h commited");
 
@@ -191,18 +205,18 @@ bool LogupVerifier::execute_logup(LogupProver& lpr, const uint64_t& rho_inv, con
     std::vector<Goldilocks2::Element> rh = randvec(numvar_h);
     end_timer("generate rg and rh");
 
-    std::array<pProver, 2> secondProvers = lpr.secondProvers(rg, rh);
+    std::array<lProver, 2> secondProvers = lpr.secondProvers(rg, rh, gamma, lambda);
     assert(secondProvers[0].get_sum() == Goldilocks2::one());
-    assert(secondProvers[1].get_sum() == ligeroVerifier::open(c, rh, sec_param));
+    set_timer("check commitment of c and open it");
+    std::vector<Goldilocks2::Element> evals_c;
+    if(!ligeroVerifier::open(c, {rh}, sec_param, evals_c)) return false;
+    end_timer("check commitment of c and open it");
+    assert(secondProvers[1].get_sum() == evals_c[0]);
 
-    set_timer("calculate eq");
-    MultilinearPolynomial eqg = eq(numvar_g, rg);
-    MultilinearPolynomial eqh = eq(numvar_h, rh);
-    end_timer("calculate eq");
     auto pcsf1 = ft[0], pcsf2 = ft[1], pcst1 = ft[2], pcst2 = ft[3];
 
     set_timer("sumcheck 3 / 4");
-    if(!pVerifier::execute_logup_sumcheck(secondProvers[0], eqg, pcsg, pcsf1, pcsf2, gamma, lambda, sec_param)){
+    if(!pVerifier::execute_logup_sumcheck(secondProvers[0], rg, pcsg, pcsf1, pcsf2, gamma, lambda, sec_param)){
         std::cout << "logup failed 2 \n";
         return false;
     }
@@ -210,7 +224,7 @@ bool LogupVerifier::execute_logup(LogupProver& lpr, const uint64_t& rho_inv, con
     // alert("sumcheck 3 / 4 finished");
 
     set_timer("sumcheck 4 / 4");
-    if(!pVerifier::execute_logup_sumcheck(secondProvers[1], eqh, pcsh, pcst1, pcst2, gamma, lambda, sec_param)){
+    if(!pVerifier::execute_logup_sumcheck(secondProvers[1], rh, pcsh, pcst1, pcst2, gamma, lambda, sec_param)){
         std::cout << "logup failed 3 \n";
         return false;   
     }
@@ -1,210 +1,385 @@
 #include "merkle.h"
 #include "goldilocks_base_field.hpp"
 #include "util.h"
+#include "sha256.h"
+#include "poseidon_goldilocks.hpp"
 
+#include <omp.h>
 #include <array>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 
-std::array<uint8_t, 16> to_bytes(const Goldilocks2::Element& e) {
-    std::array<uint8_t, 16> bytes;
-    uint64_t real = Goldilocks::toU64(e[0]);
-    uint64_t imag = Goldilocks::toU64(e[1]);
-
+// big-endian bytes of the canonical value, 8 per base field component
+static void to_bytes(const Goldilocks::Element& e, uint8_t* bytes){
+    uint64_t literal = Goldilocks::toU64(e);
     for (int i = 0; i < 8; i++) {
-        bytes[7 - i]  = (real >> (8 * i)) & 0xFF;
-        bytes[15 - i] = (imag >> (8 * i)) & 0xFF;
+        bytes[7 - i] = (literal >> (8 * i)) & 0xFF;
     }
+}
 
-    // std::cout <<"bytes of ";
-    // std::cout << Goldilocks2::toString(e) <<':';
-    // print_bytes(bytes);
-    return bytes;
+// real part first
+static void to_bytes(const Goldilocks2::Element& e, uint8_t* bytes){
+    to_bytes(e[0], bytes);
+    to_bytes(e[1], bytes + 8);
 }
 
-std::array<uint8_t, 8> to_bytes(const Goldilocks::Element& e) {
-    std::array<uint8_t, 8> bytes;
-    uint64_t literal = Goldilocks::toU64(e);
-    for (int i = 0; i < 8; i++) {
-        bytes[7 - i]  = (literal >> (8 * i)) & 0xFF;
+static_assert(sizeof(Goldilocks::Element) == 8 && sizeof(Goldilocks2::Element) == 16, "leaf bytes are sizeof(T) per element");
+
+// every hash of a tree goes through one of the hashers below, selected by MTConfig::hash:
+//     hash_columns    digests[i] = leaf hash of the n columns cols[i], num_rows elements each
+//     hash_nodes      digests[i] = hash of msgs[i], the len bytes of some adjacent child digests
+// both hash the n messages side by side where the hash allows it, scratch is the caller's reusable buffer
+
+// SHA-256 over the big-endian serialization, SHA256_LANES messages per sha256_many
+struct SHA256Hasher{
+    // a leaf is the concatenation of its column's elements, serialized into one buffer and hashed with a single update
+    template <typename T>
+    static void hash_columns(const T* const* cols, const size_t& num_rows, uint8_t* const* digests, const size_t& n, std::vector<uint8_t>& scratch){
+        const size_t len = num_rows * sizeof(T);
+        scratch.resize(std::min<size_t>(n, SHA256_LANES) * len);
+        for(size_t j = 0; j < n; j += SHA256_LANES){
+            const uint8_t* msgs[SHA256_LANES];
+            const size_t m = std::min<size_t>(SHA256_LANES, n - j);
+            for(size_t l = 0; l < m; ++l){
+                for(size_t i = 0; i < num_rows; ++i){
+                    to_bytes(cols[j + l][i], scratch.data() + l * len + i * sizeof(T));
+                }
+                msgs[l] = scratch.data() + l * len;
+            }
+            sha256_many(msgs, len, digests + j, m);
+        }
     }
 
-    // std::cout <<"bytes of ";
-    // std::cout << Goldilocks2::toString(e) <<':';
-    // print_bytes(bytes);
-    return bytes;
-}
+    static void hash_nodes(const uint8_t* const* msgs, const size_t& len, uint8_t* const* digests, const size_t& n){
+        sha256_many(msgs, len, digests, n);
+    }
+};
 
-// hash one column
-MerkleDef::Digest hash_column(const MerkleTree_ext::col_t& col){
-    // SHA256_CTX ctx;
-    // SHA256_Init(&ctx);
-    // std::array<uint8_t, SHA256_DIGEST_LENGTH> hash;
-    // // 16 for 2 * 64 / 8
-    // for(auto e: col) SHA256_Update(&ctx, to_bytes(e).data(), 16);
-    // SHA256_Final(hash.data(), &ctx);
-    // return hash;
-
-    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-    EVP_DigestInit_ex(ctx, EVP_sha256(), NULL);
-    std::array<uint8_t, SHA256_DIGEST_LENGTH> hash;
-    // 16 for 2 * 64 / 8
-    for(auto e: col) EVP_DigestUpdate(ctx, to_bytes(e).data(), 16);
-    unsigned int tmp;
-    EVP_DigestFinal_ex(ctx, hash.data(), &tmp);
-    EVP_MD_CTX_free(ctx);
-    return hash;
+// Poseidon sponge of the goldilocks library, the field elements are absorbed as they are
+// an extension element is its two base components, real part first; a digest is the 4 canonical capacity elements,
+// little-endian, so it fits MerkleDef::Digest and the node messages are the children's elements again
+struct PoseidonHasher{
+    static_assert(HASH_SIZE * sizeof(uint64_t) == SHA256_DIGEST_LENGTH, "a poseidon digest fills a MerkleDef::Digest");
+
+    static void store(const Goldilocks::Element (&hash)[HASH_SIZE], uint8_t* digest){
+        for(size_t i = 0; i < HASH_SIZE; ++i){
+            const uint64_t literal = Goldilocks::toU64(hash[i]);
+            std::memcpy(digest + i * sizeof(uint64_t), &literal, sizeof(uint64_t));
+        }
+    }
+
+    // column elements are read in place, nothing is serialized
+    template <typename T>
+    static void hash_columns(const T* const* cols, const size_t& num_rows, uint8_t* const* digests, const size_t& n, std::vector<uint8_t>&){
+        Goldilocks::Element hash[HASH_SIZE];
+        for(size_t j = 0; j < n; ++j){
+            // linear_hash only reads its input
+            PoseidonGoldilocks::linear_hash(hash, reinterpret_cast<Goldilocks::Element*>(const_cast<T*>(cols[j])), num_rows * sizeof(T) / sizeof(Goldilocks::Element));
+            store(hash, digests[j]);
+        }
+    }
+
+    static void hash_nodes(const uint8_t* const* msgs, const size_t& len, uint8_t* const* digests, const size_t& n){
+        Goldilocks::Element input[(SHA256_DIGEST_LENGTH << MERKLE_MAX_LOG_ARITY) / sizeof(uint64_t)];
+        Goldilocks::Element hash[HASH_SIZE];
+        const size_t num = len / sizeof(uint64_t);
+        for(size_t j = 0; j < n; ++j){
+            for(size_t i = 0; i < num; ++i){
+                uint64_t literal;
+                std::memcpy(&literal, msgs[j] + i * sizeof(uint64_t), sizeof(uint64_t));
+                input[i] = Goldilocks::fromU64(literal);
+            }
+            PoseidonGoldilocks::linear_hash(hash, input, num);
+            store(hash, digests[j]);
+        }
+    }
+};
+
+// call f with the hasher selected by hash
+template <typename F>
+static auto with_hasher(const MerkleDef::MTHash& hash, F&& f){
+    if(hash == MerkleDef::MTHash::Poseidon) return f(PoseidonHasher());
+    return f(SHA256Hasher());
 }
 
-// hash the column
-MerkleDef::Digest hash_column(const MerkleTree_base::col_t& col){
-    // SHA256_CTX ctx;
-    // SHA256_Init(&ctx);
-    // std::array<uint8_t, SHA256_DIGEST_LENGTH> hash;
-    // // 8 for 64 / 8
-    // for(auto e: col) SHA256_Update(&ctx, to_bytes(e).data(), 8);
-    // SHA256_Final(hash.data(), &ctx);
-
-    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-    EVP_DigestInit_ex(ctx, EVP_sha256(), NULL);
-    std::array<uint8_t, SHA256_DIGEST_LENGTH> hash;
-    // 16 for 2 * 64 / 8
-    for(auto e: col) EVP_DigestUpdate(ctx, to_bytes(e).data(), 8);
-    unsigned int tmp;
-    EVP_DigestFinal_ex(ctx, hash.data(), &tmp);
-    EVP_MD_CTX_free(ctx);
+// hash one column
+template <typename Hasher, typename T>
+static MerkleDef::Digest hash_column(const MerkleDef::ColumnView<T>& col){
+    MerkleDef::Digest hash;
+    const T* first = col.data();
+    uint8_t* digest = hash.data();
+    std::vector<uint8_t> scratch;
+    Hasher::hash_columns(&first, col.size(), &digest, 1, scratch);
     return hash;
 }
 
-// hash two child nodes
-MerkleDef::Digest hash_node(const std::array<uint8_t, SHA256_DIGEST_LENGTH>& l,const std::array<uint8_t, SHA256_DIGEST_LENGTH>& r){
-    // SHA256_CTX ctx;
-    // SHA256_Init(&ctx);
-    // std::array<uint8_t, SHA256_DIGEST_LENGTH> hash;
-    // SHA256_Update(&ctx, l.data(), SHA256_DIGEST_LENGTH);
-    // SHA256_Update(&ctx, r.data(), SHA256_DIGEST_LENGTH);
-    // SHA256_Final(hash.data(), &ctx);
-
-    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-    EVP_DigestInit_ex(ctx, EVP_sha256(), NULL);
-    std::array<uint8_t, SHA256_DIGEST_LENGTH> hash;
-    EVP_DigestUpdate(ctx, l.data(), SHA256_DIGEST_LENGTH);
-    EVP_DigestUpdate(ctx, r.data(), SHA256_DIGEST_LENGTH);
-    unsigned int tmp;
-    EVP_DigestFinal_ex(ctx, hash.data(), &tmp);
-    EVP_MD_CTX_free(ctx);
-    return hash;
+// leaves of the num_cols columns of the column major data into T[leaf_offset, leaf_offset + num_cols), SHA256_LANES columns per hash_columns
+// batches of columns are spread over the threads, each with its own scratch buffer
+template <typename Hasher, typename T>
+static void hash_leaves(const T* data, const size_t& num_rows, const size_t& num_cols, MerkleDef::MTtree& tree, const size_t& leaf_offset){
+    const size_t nbatches = (num_cols + SHA256_LANES - 1) / SHA256_LANES;
+    #pragma omp parallel if(num_cols >= MERKLE_PARALLEL_THRESHOLD && !omp_in_parallel())
+    {
+        std::vector<uint8_t> scratch;
+        const T* cols[SHA256_LANES];
+        uint8_t* digests[SHA256_LANES];
+        #pragma omp for schedule(static)
+        for(size_t batch = 0; batch < nbatches; ++batch){
+            const size_t j = batch * SHA256_LANES;
+            const size_t n = std::min<size_t>(SHA256_LANES, num_cols - j);
+            for(size_t l = 0; l < n; ++l){
+                cols[l] = data + (j + l) * num_rows;
+                digests[l] = tree[leaf_offset + j + l].data();
+            }
+            Hasher::hash_columns(cols, num_rows, digests, n, scratch);
+        }
+    }
 }
 
-// construct the merkle hash tree from a matrix
-MerkleTree_base::MerkleTree_base(const std::vector<col_t> &data){
-    size_t num_cols = data[0].size();
-    for(size_t i = 0; i < num_cols; ++i){
-        col_t col(data.size());
-        for(size_t j = 0; j < data.size(); ++j){
-            col[j] = data[j][i];
+// nodes [offset, 2 * offset) from their 2^step descendants step levels down, which are adjacent in T and hashed in place
+// the nodes of one level are independent, the levels near the root stay on the calling thread
+template <typename Hasher>
+static void hash_level(MerkleDef::MTtree& tree, const size_t& offset, const size_t& step){
+    #pragma omp parallel for schedule(static) if(offset >= MERKLE_PARALLEL_THRESHOLD && !omp_in_parallel())
+    for(size_t j = 0; j < offset; j += SHA256_LANES){
+        const uint8_t* msgs[SHA256_LANES];
+        uint8_t* digests[SHA256_LANES];
+        const size_t n = std::min<size_t>(SHA256_LANES, offset - j);
+        for(size_t l = 0; l < n; ++l){
+            const size_t idx = offset + j + l;
+            msgs[l] = tree[idx << step].data();
+            digests[l] = tree[idx].data();
         }
-        cols.push_back(col);
+        Hasher::hash_nodes(msgs, SHA256_DIGEST_LENGTH << step, digests, n);
     }
+}
+
+// levels (distance to the root) of the nodes one level above the nodes at height, 0 once the cap is reached
+static size_t next_step(const size_t& height, const MerkleDef::MTConfig& config){
+    return height > config.cap_height ? std::min(config.log_arity, height - config.cap_height) : 0;
+}
+
+// level of the tree index node, the root being 0
+static size_t height_of(const size_t& node){
+    return 63 - __builtin_clzll(node);
+}
 
+// hash the leaves into T[leaf_offset, 2 * leaf_offset) first, then every computed level up to the cap
+template <typename Hasher, typename T>
+static MerkleDef::MTtree build_tree(const T* data, const size_t& num_rows, const size_t& num_cols, const size_t& leaf_offset, const MerkleDef::MTConfig& config){
     // for clearer binary tree structure, index starts from 1 (T[0] is not used)
-    T = MerkleDef::MTtree(num_cols << 1);
-    // MTtree mt_t(num_cols << 1);
-    size_t loopN = find_ceiling_log2(num_cols);
-    leaf_offset = 1ul << loopN;
-    for(size_t j = 0; j < leaf_offset; ++j){
-        T[leaf_offset + j] = hash_column(cols[j]);
-    }
-    for(size_t i = loopN; i > 0; --i){
-        size_t offset = 1ul << (i - 1);
-        for(size_t j = 0; j < offset; ++j){
-            size_t idx = offset + j;
-            T[idx] = hash_node(T[2 * idx], T[2 * idx + 1]);
-        }
+    // leaves past num_cols (codeword length not a power of 2) stay all-zero digests
+    MerkleDef::MTtree tree(leaf_offset << 1);
+    hash_leaves<Hasher>(data, num_rows, num_cols, tree, leaf_offset);
+    for(size_t height = height_of(leaf_offset), step; (step = next_step(height, config)) != 0; height -= step){
+        hash_level<Hasher>(tree, 1ull << (height - step), step);
     }
+    return tree;
 }
 
-MerkleTree_base::MTPayload MerkleTree_base::MerkleOpen(const size_t& idx) const{
-    size_t index = leaf_offset + idx;
-    MerkleDef::MTPath path;
-    while(index != 1){
-        size_t sibling = (index ^ 1);
-        path.push_back(T[sibling]);
-        index >>= 1;
-    }
-    return MTPayload{path, cols[idx], idx + leaf_offset};
-}
-
-bool MerkleTree_base::MerkleVerify(const MerkleDef::Digest& root, const MTPayload& payload){
-    col_t col = payload.column;
-    MerkleDef::Digest hash = hash_column(col);
-    size_t index = payload.index;
-
-    for (const MerkleDef::Digest& sibling : payload.path) {
-        if ((index & 1) == 0) {
-            // this is left child
-            hash = hash_node(hash, sibling);
-        } else {
-            // this is right child
-            hash = hash_node(sibling, hash);
+// siblings needed to authenticate the nodes (tree indexes, strictly increasing, all on one level) up to the cap
+// a node whose siblings are opened as well needs fewer of them, the opened ones are hashed into their parent on the verifier side
+static MerkleDef::MTPath multi_path(const MerkleDef::MTtree& tree, std::vector<size_t> nodes, const MerkleDef::MTConfig& config){
+    MerkleDef::MTPath siblings;
+    if(nodes.empty()) return siblings;
+    for(size_t height = height_of(nodes[0]), step; (step = next_step(height, config)) != 0; height -= step){
+        std::vector<size_t> parents;
+        parents.reserve(nodes.size());
+        for(size_t k = 0; k < nodes.size();){
+            const size_t parent = nodes[k] >> step;
+            for(size_t child = parent << step; child < (parent + 1) << step; ++child){
+                if(k < nodes.size() && nodes[k] == child){
+                    ++k;
+                }else{
+                    siblings.push_back(tree[child]);
+                }
+            }
+            parents.push_back(parent);
         }
-        index >>= 1;
+        nodes.swap(parents);
     }
-    return hash == root;
+    return siblings;
 }
 
-
-// construct the merkle hash tree from a matrix
-MerkleTree_ext::MerkleTree_ext(const std::vector<col_t> &data){
-    size_t num_cols = data[0].size();
-    for(size_t i = 0; i < num_cols; ++i){
-        col_t col(data.size());
-        for(size_t j = 0; j < data.size(); ++j){
-            col[j] = data[j][i];
+// recompute the cap nodes above the nodes from their hashes, consuming the siblings in the order multi_path emits them
+// each level is one hash_nodes over all of its nodes
+template <typename Hasher>
+static bool multi_root(const MerkleDef::MTCommitment& commitment, std::vector<size_t> nodes, std::vector<MerkleDef::Digest> hashes, const MerkleDef::MTPath& siblings){
+    const MerkleDef::MTConfig& config = commitment.config;
+    size_t height = height_of(nodes[0]);
+    if(config.log_arity == 0 || config.log_arity > MERKLE_MAX_LOG_ARITY || height < config.cap_height || commitment.cap.size() != (1ull << config.cap_height)) return false;
+    size_t s = 0;
+    for(size_t step; (step = next_step(height, config)) != 0; height -= step){
+        const size_t len = SHA256_DIGEST_LENGTH << step;
+        std::vector<size_t> parents;
+        std::vector<uint8_t> bytes;
+        parents.reserve(nodes.size());
+        bytes.reserve(nodes.size() * len);
+        for(size_t k = 0; k < nodes.size();){
+            const size_t parent = nodes[k] >> step;
+            for(size_t child = parent << step; child < (parent + 1) << step; ++child){
+                const MerkleDef::Digest* hash;
+                if(k < nodes.size() && nodes[k] == child){
+                    hash = &hashes[k++];
+                }else{
+                    if(s == siblings.size()) return false;
+                    hash = &siblings[s++];
+                }
+                bytes.insert(bytes.end(), hash->begin(), hash->end());
+            }
+            parents.push_back(parent);
+        }
+        std::vector<MerkleDef::Digest> next(parents.size());
+        std::vector<const uint8_t*> msgs(parents.size());
+        std::vector<uint8_t*> digests(parents.size());
+        for(size_t k = 0; k < parents.size(); ++k){
+            msgs[k] = bytes.data() + k * len;
+            digests[k] = next[k].data();
         }
-        cols.push_back(col);
+        Hasher::hash_nodes(msgs.data(), len, digests.data(), parents.size());
+        nodes.swap(parents);
+        hashes.swap(next);
+    }
+    if(s != siblings.size()) return false;
+    for(size_t k = 0; k < nodes.size(); ++k){
+        if(hashes[k] != commitment.cap[nodes[k] - (1ull << height)]) return false;
     }
+    return true;
+}
 
-    // for clearer binary tree structure, index starts from 1 (T[0] is not used)
-    T = MerkleDef::MTtree(num_cols << 1);
-    // MTtree mt_t(num_cols << 1);
-    size_t loopN = find_ceiling_log2(num_cols);
-    leaf_offset = 1ul << loopN;
-    for(size_t j = 0; j < leaf_offset; ++j){
-        T[leaf_offset + j] = hash_column(cols[j]);
-    }
-    for(size_t i = loopN; i > 0; --i){
-        size_t offset = 1ul << (i - 1);
-        for(size_t j = 0; j < offset; ++j){
-            size_t idx = offset + j;
-            T[idx] = hash_node(T[2 * idx], T[2 * idx + 1]);
+// the columns of one multiproof all have the same length, they are hashed SHA256_LANES at a time
+// and, when there is enough to hash, with the batches spread over the threads
+template <typename Hasher, typename Payload>
+static bool multi_verify(const MerkleDef::MTCommitment& commitment, const Payload& payload){
+    const auto& cols = payload.columns;
+    const auto& nodes = payload.indexes;
+    if(cols.empty() || cols.size() != nodes.size() || nodes[0] == 0) return false;
+    for(size_t k = 1; k < nodes.size(); ++k){
+        // strictly increasing and on the level of nodes[0]: same highest bit, so the xor stays below nodes[0]
+        if(nodes[k] <= nodes[k - 1] || (nodes[k] ^ nodes[0]) >= nodes[0]) return false;
+        if(cols[k].size() != cols[0].size()) return false;
+    }
+    std::vector<MerkleDef::Digest> hashes(cols.size());
+    std::vector<decltype(cols[0].data())> firsts(cols.size());
+    std::vector<uint8_t*> digests(cols.size());
+    for(size_t k = 0; k < cols.size(); ++k){
+        firsts[k] = cols[k].data();
+        digests[k] = hashes[k].data();
+    }
+    const size_t len = cols[0].size();
+    const size_t nbatches = (cols.size() + SHA256_LANES - 1) / SHA256_LANES;
+    #pragma omp parallel if(cols.size() * len >= MERKLE_VERIFY_PARALLEL_ELEMENTS && !omp_in_parallel())
+    {
+        std::vector<uint8_t> scratch;
+        #pragma omp for schedule(static)
+        for(size_t batch = 0; batch < nbatches; ++batch){
+            const size_t j = batch * SHA256_LANES;
+            Hasher::hash_columns(firsts.data() + j, len, digests.data() + j, std::min<size_t>(SHA256_LANES, cols.size() - j), scratch);
         }
     }
+    return multi_root<Hasher>(commitment, nodes, std::move(hashes), payload.siblings);
+}
+
+// construct the merkle hash tree from a matrix
+MerkleTree_base::MerkleTree_base(const std::shared_ptr<const std::vector<Goldilocks::Element>>& data, const size_t& num_rows, const size_t& num_cols, const MerkleDef::MTConfig& config):
+    data(data), num_rows(num_rows), num_cols(num_cols){
+    assert(data->size() == num_rows * num_cols && config.log_arity > 0 && config.log_arity <= MERKLE_MAX_LOG_ARITY);
+    leaf_offset = 1ul << find_ceiling_log2(num_cols);
+    this->config = {config.log_arity, std::min(config.cap_height, height_of(leaf_offset)), config.hash};
+    T = with_hasher(config.hash, [&](auto hasher){
+        return build_tree<decltype(hasher)>(data->data(), num_rows, num_cols, leaf_offset, this->config);
+    });
+}
+
+MerkleDef::MTCommitment MerkleTree_base::MerkleCommit() const{
+    const size_t first = 1ull << config.cap_height;
+    return {std::vector<MerkleDef::Digest>(T.begin() + first, T.begin() + 2 * first), config};
+}
+
+MerkleTree_base::MTPayload MerkleTree_base::MerkleOpen(const size_t& idx) const{
+    assert(idx < num_cols);
+    return MTPayload{multi_path(T, {idx + leaf_offset}, config), col_t(data, idx * num_rows, num_rows), idx + leaf_offset};
+}
+
+MerkleTree_base::MTMultiPayload MerkleTree_base::MerkleMultiOpen(const std::vector<size_t>& idxs) const{
+    std::vector<size_t> sorted(idxs);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    MTMultiPayload payload;
+    payload.columns.reserve(sorted.size());
+    payload.indexes.reserve(sorted.size());
+    for(size_t idx: sorted){
+        assert(idx < num_cols);
+        payload.columns.push_back(col_t(data, idx * num_rows, num_rows));
+        payload.indexes.push_back(idx + leaf_offset);
+    }
+    payload.siblings = multi_path(T, payload.indexes, config);
+    return payload;
+}
+
+bool MerkleTree_base::MerkleVerify(const MerkleDef::MTCommitment& commitment, const MTPayload& payload){
+    if(payload.index == 0) return false;
+    return with_hasher(commitment.config.hash, [&](auto hasher){
+        typedef decltype(hasher) Hasher;
+        return multi_root<Hasher>(commitment, {payload.index}, {hash_column<Hasher>(payload.column)}, payload.path);
+    });
+}
+
+bool MerkleTree_base::MerkleMultiVerify(const MerkleDef::MTCommitment& commitment, const MTMultiPayload& payload){
+    return with_hasher(commitment.config.hash, [&](auto hasher){
+        return multi_verify<decltype(hasher)>(commitment, payload);
+    });
+}
+
+
+// construct the merkle hash tree from a matrix
+MerkleTree_ext::MerkleTree_ext(const std::shared_ptr<const std::vector<Goldilocks2::Element>>& data, const size_t& num_rows, const size_t& num_cols, const MerkleDef::MTConfig& config):
+    data(data), num_rows(num_rows), num_cols(num_cols){
+    assert(data->size() == num_rows * num_cols && config.log_arity > 0 && config.log_arity <= MERKLE_MAX_LOG_ARITY);
+    leaf_offset = 1ul << find_ceiling_log2(num_cols);
+    this->config = {config.log_arity, std::min(config.cap_height, height_of(leaf_offset)), config.hash};
+    T = with_hasher(config.hash, [&](auto hasher){
+        return build_tree<decltype(hasher)>(data->data(), num_rows, num_cols, leaf_offset, this->config);
+    });
+}
+
+MerkleDef::MTCommitment MerkleTree_ext::MerkleCommit() const{
+    const size_t first = 1ull << config.cap_height;
+    return {std::vector<MerkleDef::Digest>(T.begin() + first, T.begin() + 2 * first), config};
 }
 
 MerkleTree_ext::MTPayload MerkleTree_ext::MerkleOpen(const size_t& idx) const{
-    size_t index = leaf_offset + idx;
-    MerkleDef::MTPath path;
-    while(index != 1){
-        size_t sibling = (index ^ 1);
-        path.push_back(T[sibling]);
-        index >>= 1;
-    }
-    return MTPayload{path, cols[idx], idx + leaf_offset};
-}
-
-bool MerkleTree_ext::MerkleVerify(const MerkleDef::Digest& root, const MTPayload& payload){
-    col_t col = payload.column;
-    MerkleDef::Digest hash = hash_column(col);
-    size_t index = payload.index;
-
-    for (const MerkleDef::Digest& sibling : payload.path) {
-        if ((index & 1) == 0) {
-            // this is left child
-            hash = hash_node(hash, sibling);
-        } else {
-            // this is right child
-            hash = hash_node(sibling, hash);
-        }
-        index >>= 1;
+    assert(idx < num_cols);
+    return MTPayload{multi_path(T, {idx + leaf_offset}, config), col_t(data, idx * num_rows, num_rows), idx + leaf_offset};
+}
+
+MerkleTree_ext::MTMultiPayload MerkleTree_ext::MerkleMultiOpen(const std::vector<size_t>& idxs) const{
+    std::vector<size_t> sorted(idxs);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    MTMultiPayload payload;
+    payload.columns.reserve(sorted.size());
+    payload.indexes.reserve(sorted.size());
+    for(size_t idx: sorted){
+        assert(idx < num_cols);
+        payload.columns.push_back(col_t(data, idx * num_rows, num_rows));
+        payload.indexes.push_back(idx + leaf_offset);
     }
-    return hash == root;
+    payload.siblings = multi_path(T, payload.indexes, config);
+    return payload;
+}
+
+bool MerkleTree_ext::MerkleVerify(const MerkleDef::MTCommitment& commitment, const MTPayload& payload){
+    if(payload.index == 0) return false;
+    return with_hasher(commitment.config.hash, [&](auto hasher){
+        typedef decltype(hasher) Hasher;
+        return multi_root<Hasher>(commitment, {payload.index}, {hash_column<Hasher>(payload.column)}, payload.path);
+    });
+}
+
+bool MerkleTree_ext::MerkleMultiVerify(const MerkleDef::MTCommitment& commitment, const MTMultiPayload& payload){
+    return with_hasher(commitment.config.hash, [&](auto hasher){
+        return multi_verify<decltype(hasher)>(commitment, payload);
+    });
 }
@@ -0,0 +1,509 @@
+#include "ntt.h"
+#include "ntt_simd.h"
+#include "goldilocks_quadratic_ext.h"
+#include "util.h"
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory>
+#include <mutex>
+
+size_t highest_bit_mask(const size_t& n){
+    size_t mask = ~(SIZE_MAX >> 1);
+    while(mask != 0){
+        if(mask & n) return mask;
+        mask = mask >> 1;
+    }
+    return 0;
+}
+
+size_t reverse_bits(size_t i, const size_t& logn){
+    if(logn == 0) return 0;
+    i = ((i >> 1) & 0x5555555555555555ull) | ((i & 0x5555555555555555ull) << 1);
+    i = ((i >> 2) & 0x3333333333333333ull) | ((i & 0x3333333333333333ull) << 2);
+    i = ((i >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((i & 0x0F0F0F0F0F0F0F0Full) << 4);
+    i = ((i >> 8) & 0x00FF00FF00FF00FFull) | ((i & 0x00FF00FF00FF00FFull) << 8);
+    i = ((i >> 16) & 0x0000FFFF0000FFFFull) | ((i & 0x0000FFFF0000FFFFull) << 16);
+    i = (i >> 32) | (i << 32);
+    return i >> (64 - logn);
+}
+
+static Goldilocks::Element pow(Goldilocks::Element base, uint64_t e){
+    Goldilocks::Element res = Goldilocks::one();
+    while(e){
+        if(e & 1) Goldilocks::mul(res, res, base);
+        Goldilocks::mul(base, base, base);
+        e >>= 1;
+    }
+    return res;
+}
+
+bool has_ntt_domain(const size_t& N){
+    if(N == 0) return false;
+    const size_t k = __builtin_ctzll(N);
+    return k <= 32 && NTT_ODD_ORDER % (N >> k) == 0;
+}
+
+Goldilocks::Element domain_generator(const size_t& N){
+    assert(has_ntt_domain(N));
+    const size_t k = __builtin_ctzll(N);
+    const uint64_t r = N >> k;
+    // omega = zeta * beta with zeta of order r and beta^r = ROOTS[k], so omega^r is the root the radix-2 tables use
+    const Goldilocks::Element zeta = pow(Goldilocks::fromU64(NTT_COSET_SHIFT), (GOLDILOCKS_PRIME - 1) / r);
+    // r^{-1} mod 2^k by newton iteration, r is odd
+    uint64_t r_inv = r;
+    for(int i = 0; i < 5; ++i) r_inv *= 2 - r * r_inv;
+    const uint64_t mask = (k == 64) ? ~0ull : (1ull << k) - 1;
+    const Goldilocks::Element beta = pow(ROOTS[k], r_inv & mask);
+    return Goldilocks::mul(zeta, beta);
+}
+
+const TwiddleTable& get_twiddles(const size_t& logn){
+    assert(logn <= 32);
+    static std::array<std::unique_ptr<TwiddleTable>, 33> tables;
+    static std::array<std::once_flag, 33> built;
+    std::call_once(built[logn], [logn](){
+        const size_t n = 1ull << logn;
+        auto table = std::make_unique<TwiddleTable>();
+        table->logn = logn;
+        table->fwd.resize(std::max<size_t>(n, 2));
+        table->inv.resize(std::max<size_t>(n, 2));
+        // the last stage is a chain of powers of the n-th root
+        // every lower stage is the even half of the one above: omega_{2h}^j = omega_{4h}^{2j}
+        if(n >= 2){
+            const size_t half = n >> 1;
+            const Goldilocks::Element w = ROOTS[logn], w_inv = Goldilocks::inv(ROOTS[logn]);
+            table->fwd[half] = Goldilocks::one();
+            table->inv[half] = Goldilocks::one();
+            for(size_t j = 1; j < half; ++j){
+                Goldilocks::mul(table->fwd[half + j], table->fwd[half + j - 1], w);
+                Goldilocks::mul(table->inv[half + j], table->inv[half + j - 1], w_inv);
+            }
+            for(size_t h = half >> 1; h > 0; h >>= 1){
+                for(size_t j = 0; j < h; ++j){
+                    table->fwd[h + j] = table->fwd[2 * h + 2 * j];
+                    table->inv[h + j] = table->inv[2 * h + 2 * j];
+                }
+            }
+        }
+        const Goldilocks::Element g = Goldilocks::fromU64(NTT_COSET_SHIFT), g_inv = Goldilocks::inv(g);
+        table->coset.resize(n);
+        table->coset_inv.resize(n);
+        table->coset[0] = Goldilocks::one();
+        table->coset_inv[0] = Goldilocks::one();
+        for(size_t i = 1; i < n; ++i){
+            Goldilocks::mul(table->coset[i], table->coset[i - 1], g);
+            Goldilocks::mul(table->coset_inv[i], table->coset_inv[i - 1], g_inv);
+        }
+        table->n_inv = Goldilocks::inv(Goldilocks::fromU64(n));
+        tables[logn] = std::move(table);
+    });
+    return *tables[logn];
+}
+
+// the transforms below are written once for both fields, the twiddles are base field elements in either case
+template <typename T> struct NTTField;
+
+template <> struct NTTField<Goldilocks::Element>{
+    static Goldilocks::Element zero(){ return Goldilocks::zero(); }
+    static void add(Goldilocks::Element& r, const Goldilocks::Element& a, const Goldilocks::Element& b){ Goldilocks::add(r, a, b); }
+    static void sub(Goldilocks::Element& r, const Goldilocks::Element& a, const Goldilocks::Element& b){ Goldilocks::sub(r, a, b); }
+    static void mul(Goldilocks::Element& r, const Goldilocks::Element& a, const Goldilocks::Element& w){ Goldilocks::mul(r, a, w); }
+    static ButterflyKernel butterfly(){ return get_ntt_kernels().butterfly; }
+    static ScalePowersKernel scale_powers(){ return get_ntt_kernels().scale_powers; }
+};
+
+// extension elements stay interleaved, one pass transforms both components
+template <> struct NTTField<Goldilocks2::Element>{
+    static Goldilocks2::Element zero(){ return Goldilocks2::zero(); }
+    static void add(Goldilocks2::Element& r, const Goldilocks2::Element& a, const Goldilocks2::Element& b){ Goldilocks2::add(r, a, b); }
+    static void sub(Goldilocks2::Element& r, const Goldilocks2::Element& a, const Goldilocks2::Element& b){ Goldilocks2::sub(r, a, b); }
+    static void mul(Goldilocks2::Element& r, const Goldilocks2::Element& a, const Goldilocks::Element& w){ Goldilocks2::mul(r, a, w); }
+    static ExtButterflyKernel butterfly(){ return get_ntt_kernels().butterfly_ext; }
+    static ExtScalePowersKernel scale_powers(){ return get_ntt_kernels().scale_powers_ext; }
+};
+
+// [begin, end) of the n iterations owned by thread tid of nthreads, contiguous as with schedule(static)
+static inline void thread_range(const size_t& n, const size_t& tid, const size_t& nthreads, size_t& begin, size_t& end){
+    begin = n * tid / nthreads;
+    end = n * (tid + 1) / nthreads;
+}
+
+/*
+cache-blocked bit-reversal (COBRA style), logn >= 2 * NTT_LOG_TILE
+split i = (hi, mid, lo) with hi and lo of q = NTT_LOG_TILE bits, then rev(i) = (rev(lo), rev(mid), rev(hi)):
+the 2^q x 2^q tile of all i sharing mid swaps with the tile of rev(mid), transposed and with both coordinates reversed.
+tiles are read and written one row (2^q contiguous elements) at a time instead of one cache line per element
+thread tid of nthreads handles its share of the tile pairs, the caller synchronizes
+*/
+template <typename T>
+static void bit_reverse_tiles(T* a, const size_t& logn, const size_t& tid, const size_t& nthreads){
+    const size_t q = NTT_LOG_TILE, t = 1ull << q;
+    const size_t mid_bits = logn - 2 * q, row_shift = logn - q;
+    size_t begin, end;
+    thread_range(1ull << mid_bits, tid, nthreads, begin, end);
+    for(size_t mid = begin; mid < end; ++mid){
+        const size_t mid_r = reverse_bits(mid, mid_bits);
+        // every pair of tiles is owned by its smaller mid
+        if(mid_r < mid) continue;
+        T tile[2][t][t];
+        for(size_t hi = 0; hi < t; ++hi){
+            std::copy(a + ((hi << row_shift) | (mid << q)), a + ((hi << row_shift) | (mid << q)) + t, tile[0][hi]);
+            std::copy(a + ((hi << row_shift) | (mid_r << q)), a + ((hi << row_shift) | (mid_r << q)) + t, tile[1][hi]);
+        }
+        // (hi, mid_r, lo) receives (rev(lo), mid, rev(hi)) and vice versa
+        for(size_t hi = 0; hi < t; ++hi){
+            const size_t src_lo = reverse_bits(hi, q);
+            for(size_t lo = 0; lo < t; ++lo){
+                const size_t src_hi = reverse_bits(lo, q);
+                a[(hi << row_shift) | (mid_r << q) | lo] = tile[0][src_hi][src_lo];
+                a[(hi << row_shift) | (mid << q) | lo] = tile[1][src_hi][src_lo];
+            }
+        }
+    }
+}
+
+// radix-2 transform with the stage twiddles tw (laid out as in TwiddleTable)
+// starts at blocks of length first_len, the caller may have done the bit-reversal and earlier stages already
+// the work is split by hand so that a transform on one thread (e.g. the sqrt(N)-sized ones of six_step) runs without any OpenMP construct
+template <typename T>
+static void ntt_core(T* a, const size_t& n, const std::vector<Goldilocks::Element>& tw, const size_t& first_len = 2, const bool& bit_reverse = true){
+    if(n == 1) return;
+    const size_t logn = __builtin_ctzll(n);
+    // nested calls (e.g. one NTT per row inside a parallel loop) stay on their thread
+    const bool parallel = n >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel() && omp_get_max_threads() > 1;
+    const auto butterfly = NTTField<T>::butterfly();
+
+    const auto body = [&](const size_t tid, const size_t nthreads){
+        // every pass reads what the others wrote in the previous one
+        const auto sync = [nthreads](){
+            if(nthreads > 1){
+                #pragma omp barrier
+            }
+        };
+        size_t begin, end;
+
+        // Bit-reverse permutation, tile by tile once the array outgrows the L1 cache
+        if (bit_reverse && n >= NTT_PARALLEL_THRESHOLD) {
+            bit_reverse_tiles(a, logn, tid, nthreads);
+            sync();
+        } else if (bit_reverse) {
+            // every swap is owned by its smaller index
+            thread_range(n, tid, nthreads, begin, end);
+            for (size_t i = begin; i < end; ++i) {
+                size_t j = reverse_bits(i, logn);
+                if (i < j) std::swap(a[i], a[j]);
+            }
+            sync();
+        }
+
+        // Iterative Cooley-Tukey NTT
+        for (size_t len = first_len; len <= n; len <<= 1) {
+            const size_t half = len >> 1;
+            const size_t nblocks = n / len;
+            const Goldilocks::Element* w = tw.data() + half; // omega_len^j
+            if (half < NTT_INLINE_HALF) {
+                // the first stages: the vector kernels would run scalar on such short halves, so skip the call per block
+                // (and the multiplication by w[0] = 1)
+                thread_range(nblocks, tid, nthreads, begin, end);
+                for (size_t blk = begin; blk < end; ++blk) {
+                    T* u = a + blk * len;
+                    T* v = u + half;
+                    for (size_t j = 0; j < half; ++j) {
+                        T t = v[j];
+                        if (j != 0) NTTField<T>::mul(t, v[j], w[j]);
+                        NTTField<T>::sub(v[j], u[j], t);
+                        NTTField<T>::add(u[j], u[j], t);
+                    }
+                }
+            } else if (nblocks >= nthreads) {
+                // early stages: enough independent blocks for every thread
+                thread_range(nblocks, tid, nthreads, begin, end);
+                for (size_t blk = begin; blk < end; ++blk) {
+                    butterfly(a + blk * len, half, w, 0, half);
+                }
+            } else {
+                // late stages: split each block into contiguous runs of butterflies
+                const size_t chunks = std::min(half, (nthreads + nblocks - 1) / nblocks);
+                thread_range(nblocks * chunks, tid, nthreads, begin, end);
+                for (size_t task = begin; task < end; ++task) {
+                    const size_t blk = task / chunks, c = task % chunks;
+                    butterfly(a + blk * len, half, w, half * c / chunks, half * (c + 1) / chunks);
+                }
+            }
+            sync();
+        }
+    };
+
+    if (parallel) {
+        #pragma omp parallel
+        body(omp_get_thread_num(), omp_get_num_threads());
+    } else {
+        body(0, 1);
+    }
+}
+
+/*
+the len coefficients zero padded to m = ntt_size(len) and then to N land, after the bit-reversal,
+at multiples of N / m; every stage with blocks up to N / m then only copies them into the zero slots.
+so write each coefficient straight into its whole block and start the transform at the next stage
+coef(i) is the i-th coefficient, returns the first block length left to the transform
+*/
+template <typename T, typename Coef>
+static size_t lde_scatter(T* out, const size_t& len, const size_t& N, const Coef& coef){
+    const size_t m = ntt_size(len);
+    assert(m <= N);
+    const size_t logm = __builtin_ctzll(m);
+    const size_t block = N / m;
+    const auto scatter = [&](const size_t i){
+        const T c = i < len ? coef(i) : NTTField<T>::zero();
+        T* dst = out + (reverse_bits(i, logm) * block);
+        std::fill(dst, dst + block, c);
+    };
+    // no serialized parallel region for the small transforms of six_step
+    if(N >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel()){
+        #pragma omp parallel for schedule(static)
+        for(size_t i = 0; i < m; ++i) scatter(i);
+    }else{
+        for(size_t i = 0; i < m; ++i) scatter(i);
+    }
+    return block << 1;
+}
+
+// dst (cols x rows) = transpose of src (rows x cols, row-major), tile by tile so that both sides stay in cache
+// with bit_reverse every row of dst comes out in bit-reversed order (rows a power of 2), ready for ntt_core without its permutation
+template <typename T>
+static void transpose_blocked(const T* src, T* dst, const size_t& rows, const size_t& cols, const bool& bit_reverse = false){
+    const size_t t = 1ull << NTT_LOG_TILE;
+    const size_t logrows = __builtin_ctzll(rows);
+    const size_t row_tiles = (rows + t - 1) / t, col_tiles = (cols + t - 1) / t;
+    #pragma omp parallel for schedule(static) if(rows * cols >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel())
+    for(size_t tile = 0; tile < row_tiles * col_tiles; ++tile){
+        const size_t i0 = (tile / col_tiles) * t, j0 = (tile % col_tiles) * t;
+        const size_t i1 = std::min(i0 + t, rows), j1 = std::min(j0 + t, cols);
+        for(size_t j = j0; j < j1; ++j){
+            for(size_t i = i0; i < i1; ++i){
+                dst[j * rows + (bit_reverse ? reverse_bits(i, logrows) : i)] = src[i * cols + j];
+            }
+        }
+    }
+}
+
+/*
+six-step (Bailey) transform of size N = n1 * n2 with n1 = 2^floor(logN / 2), for arrays beyond the cache.
+with x[n2 i1 + i2] = coef(n2 i1 + i2) (zero from len on) and X[k1 + n1 k2] its transform:
+    X[k1 + n1 k2] = sum_i2 omega_n2^{i2 k2} * (omega_N^{i2 k1} * sum_i1 omega_n1^{i1 k1} x[n2 i1 + i2])
+    1. gather the column i2 of x as row i2 of out (n2 x n1) and transform it, pruned like lde_with_ntt
+    2. scale (i2, k1) by omega_N^{i2 k1} while the row is still in cache
+    3. transpose out into scratch (n1 x n2), every row in bit-reversed order
+    4. transform the rows of scratch, already permuted
+    5. transpose scratch back into out (n2 x n1), which is X in natural order
+every sub-transform fits in cache, so the array is streamed a fixed number of times whatever N is
+scratch (N entries) is owned by the caller, coef is only called in the first pass and may read from scratch
+*/
+template <typename T, typename Coef>
+static void six_step(T* out, T* scratch, const size_t& len, const size_t& N, const Coef& coef){
+    const size_t logN = __builtin_ctzll(N);
+    const size_t n1 = 1ull << (logN >> 1), n2 = N / n1;
+    const std::vector<Goldilocks::Element>& tw1 = get_twiddles(logN >> 1).fwd;
+    const std::vector<Goldilocks::Element>& tw2 = get_twiddles(logN - (logN >> 1)).fwd;
+    // the first m1 entries of every column hold all the coefficients
+    const size_t m1 = std::min(n1, (len + n2 - 1) / n2);
+    const auto scale_powers = NTTField<T>::scale_powers();
+
+    #pragma omp parallel for schedule(static) if(!omp_in_parallel())
+    for(size_t i2 = 0; i2 < n2; ++i2){
+        T* row = out + i2 * n1;
+        const size_t first_len = lde_scatter(row, m1, n1, [&coef, len, n2, i2](const size_t& i1){
+            const size_t i = n2 * i1 + i2;
+            return i < len ? coef(i) : NTTField<T>::zero();
+        });
+        ntt_core(row, n1, tw1, first_len, false);
+        scale_powers(row, n1, pow(ROOTS[logN], i2));
+    }
+    transpose_blocked(out, scratch, n2, n1, true);
+    #pragma omp parallel for schedule(static) if(!omp_in_parallel())
+    for(size_t k1 = 0; k1 < n1; ++k1){
+        ntt_core(scratch + k1 * n2, n2, tw2, 2, false);
+    }
+    transpose_blocked(scratch, out, n1, n2);
+}
+
+// entries of scratch lde_core needs for a transform of size N, none below the six-step size
+template <typename T>
+static size_t six_step_scratch(const size_t& N){
+    return N * sizeof(T) >= NTT_SIX_STEP_BYTES ? N : 0;
+}
+
+// zero padded transform of the len coefficients coef(i) to size N, six-step for large N
+// scratch holds six_step_scratch<T>(N) entries
+template <typename T, typename Coef>
+static void lde_core(T* out, const size_t& len, const size_t& N, const Coef& coef, T* scratch){
+    if(six_step_scratch<T>(N) != 0){
+        six_step(out, scratch, len, N, coef);
+        return;
+    }
+    const size_t first_len = lde_scatter(out, len, N, coef);
+    ntt_core(out, N, get_twiddles(__builtin_ctzll(N)).fwd, first_len, false);
+}
+
+void in_place_NTT(Goldilocks::Element* a, const size_t& n){
+    assert(is_power_of_2(n));
+    if(six_step_scratch<Goldilocks::Element>(n) != 0){
+        // the first pass gathers the columns straight from a into scratch, which ends up holding the transform,
+        // and a serves as the second buffer: 2n entries at the peak, one extra copy back into a
+        std::vector<Goldilocks::Element> scratch(n);
+        six_step(scratch.data(), a, n, n, [a](const size_t& i){ return a[i]; });
+        std::copy(scratch.begin(), scratch.end(), a);
+        return;
+    }
+    ntt_core(a, n, get_twiddles(__builtin_ctzll(n)).fwd);
+}
+
+void in_place_INTT(Goldilocks::Element* a, const size_t& n){
+    assert(is_power_of_2(n));
+    const TwiddleTable& table = get_twiddles(__builtin_ctzll(n));
+    ntt_core(a, n, table.inv);
+    #pragma omp parallel for schedule(static) if(n >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel())
+    for(size_t i = 0; i < n; ++i){
+        Goldilocks::mul(a[i], a[i], table.n_inv);
+    }
+}
+
+void in_place_coset_NTT(Goldilocks::Element* a, const size_t& n){
+    assert(is_power_of_2(n));
+    const TwiddleTable& table = get_twiddles(__builtin_ctzll(n));
+    #pragma omp parallel for schedule(static) if(n >= NTT_PARALLEL_THRESHOLD && !omp_in_parallel())
+    for(size_t i = 0; i < n; ++i){
+        Goldilocks::mul(a[i], a[i], table.coset[i]);
+    }
+    ntt_core(a, n, table.fwd);
+}
+
+void in_place_NTT(std::vector<Goldilocks::Element>& a) {
+    in_place_NTT(a.data(), a.size());
+}
+
+std::vector<Goldilocks::Element> NTT(const std::vector<Goldilocks::Element>& input) {
+    std::vector<Goldilocks::Element> a = input;
+    in_place_NTT(a);
+    return a;
+}
+
+size_t ntt_size(const size_t& N){
+    return is_power_of_2(N) ? N : highest_bit_mask(N) << 1;
+}
+
+void lde_with_ntt(const Goldilocks::Element* f, const size_t& len, const size_t& N, Goldilocks::Element* out){
+    assert(is_power_of_2(N) && len >= 1);
+    std::vector<Goldilocks::Element> scratch(six_step_scratch<Goldilocks::Element>(N));
+    lde_core(out, len, N, [f, len](const size_t& i){ return f[len - 1 - i]; }, scratch.data());
+}
+
+void lde_with_ntt(const Goldilocks2::Element* f, const size_t& len, const size_t& N, Goldilocks2::Element* out){
+    assert(is_power_of_2(N) && len >= 1);
+    std::vector<Goldilocks2::Element> scratch(six_step_scratch<Goldilocks2::Element>(N));
+    lde_core(out, len, N, [f, len](const size_t& i){ return f[len - 1 - i]; }, scratch.data());
+}
+
+/*
+N = r * M with r odd and M a power of 2. with omega = domain_generator(N) and omega^r the M-th root of the tables:
+    out[s + r * j] = sum_i c_i omega^{i s} (omega^r)^{i j},  s < r, j < M
+so every residue s is an M-point transform of the coefficients scaled by omega^{i s} (folded modulo M when len > M)
+coef(i) is the i-th coefficient, scratch holds 2M + six_step_scratch<T>(M) elements
+*/
+template <typename T, typename Coef>
+static void mixed_radix_eval(const size_t& len, const size_t& N, const Coef& coef, T* out, T* scratch){
+    const size_t M = 1ull << __builtin_ctzll(N), r = N / M;
+    const Goldilocks::Element omega = domain_generator(N);
+    // omega^M has order r
+    const Goldilocks::Element omega_M = pow(omega, M);
+    T* coset = scratch;
+    T* buf = scratch + M;
+    const size_t m = std::min(len, M);
+
+    Goldilocks::Element omega_s = Goldilocks::one();
+    for(size_t s = 0; s < r; ++s){
+        const Goldilocks::Element omega_Ms = pow(omega_M, s);
+        Goldilocks::Element pw = Goldilocks::one();
+        for(size_t i = 0; i < m; ++i){
+            // sum_t c_{i + t M} (omega^{M s})^t, a single term unless len > M
+            T folded = NTTField<T>::zero(), term;
+            Goldilocks::Element wt = Goldilocks::one();
+            for(size_t idx = i; idx < len; idx += M){
+                NTTField<T>::mul(term, coef(idx), wt);
+                NTTField<T>::add(folded, folded, term);
+                Goldilocks::mul(wt, wt, omega_Ms);
+            }
+            NTTField<T>::mul(coset[i], folded, pw);
+            Goldilocks::mul(pw, pw, omega_s);
+        }
+        lde_core(buf, m, M, [coset](const size_t& i){ return coset[i]; }, scratch + 2 * M);
+        for(size_t j = 0; j < M; ++j){
+            out[s + r * j] = buf[j];
+        }
+        Goldilocks::mul(omega_s, omega_s, omega);
+    }
+}
+
+template <typename T>
+static void eval_impl(const T* f, const size_t& len, const size_t& N, T* out, std::vector<T>& scratch){
+    const size_t N_used = ntt_size(N);
+    assert(len <= N_used && len >= 1);
+    const auto coef = [f, len](const size_t& i){ return f[len - 1 - i]; };
+    // resize only grows the capacity, so a scratch reused across rows is allocated once
+    if(N_used == N){
+        scratch.resize(std::max(scratch.size(), six_step_scratch<T>(N)));
+        lde_core(out, len, N, coef, scratch.data());
+        return;
+    }
+    if(has_ntt_domain(N)){
+        const size_t M = 1ull << __builtin_ctzll(N);
+        scratch.resize(std::max(scratch.size(), 2 * M + six_step_scratch<T>(M)));
+        mixed_radix_eval(len, N, coef, out, scratch.data());
+        return;
+    }
+    // no subgroup of order N, transform the padded vector in scratch and trim when copying out
+    scratch.resize(std::max(scratch.size(), N_used + six_step_scratch<T>(N_used)));
+    lde_core(scratch.data(), len, N_used, coef, scratch.data() + N_used);
+    std::copy(scratch.begin(), scratch.begin() + N, out);
+}
+
+void eval_with_ntt(const Goldilocks::Element* f, const size_t& len, const size_t& N, Goldilocks::Element* out, std::vector<Goldilocks::Element>& scratch){
+    eval_impl(f, len, N, out, scratch);
+}
+
+void eval_with_ntt(const Goldilocks2::Element* f, const size_t& len, const size_t& N, Goldilocks2::Element* out, std::vector<Goldilocks2::Element>& scratch){
+    eval_impl(f, len, N, out, scratch);
+}
+
+std::vector<Goldilocks::Element> eval_with_ntt(const std::vector<Goldilocks::Element>& f, const size_t& N){
+    std::vector<Goldilocks::Element> result(N), scratch;
+    eval_with_ntt(f.data(), f.size(), N, result.data(), scratch);
+    return result;
+}
+
+std::vector<Goldilocks2::Element> eval_with_ntt(const std::vector<Goldilocks2::Element>& f, const size_t& N){
+    std::vector<Goldilocks2::Element> result(N), scratch;
+    eval_with_ntt(f.data(), f.size(), N, result.data(), scratch);
+    return result;
+}
+
+std::vector<Goldilocks::Element> eval_with_ntt_base(std::vector<Goldilocks2::Element> f, const size_t& N){
+    std::vector<Goldilocks::Element> base_field_copy(f.size());
+    for(size_t i = 0; i < f.size(); ++i){
+        base_field_copy[i] = f[i][0];
+    }
+    return eval_with_ntt(base_field_copy, N);
+}
+
+std::vector<Goldilocks2::Element> eval_with_ntt_ext(std::vector<Goldilocks2::Element> f, const size_t& N){
+    std::vector<Goldilocks::Element> base = eval_with_ntt_base(f, N);
+    std::vector<Goldilocks2::Element> ext(base.size());
+    for (size_t i = 0;i < base.size(); ++i){
+        ext[i][0] = base[i];
+        ext[i][1] = Goldilocks::zero();
+    }
+    return ext;
+}
@@ -0,0 +1,315 @@
+#include "ntt_simd.h"
+#include "goldilocks_base_field.hpp"
+#include "goldilocks_quadratic_ext.h"
+#include <immintrin.h>
+#include <atomic>
+
+/*
+lane arithmetic mod p = 2^64 - 2^32 + 1, with 2^64 = EPSILON = 2^32 - 1 (mod p)
+inputs may be any 64-bit representative, every result is canonical (< p)
+*/
+#define GL_P 0xFFFFFFFF00000001ull
+#define GL_EPSILON 0xFFFFFFFFull
+
+void butterfly_scalar(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end){
+    for (size_t j = begin; j < end; ++j) {
+        auto &u = a[j];
+        auto &v = a[j + half];
+        Goldilocks::Element t = Goldilocks::mul(w[j], v);
+        v = u - t;
+        u = u + t;
+    }
+}
+
+void scale_powers_scalar(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w){
+    Goldilocks::Element wk = Goldilocks::one();
+    for (size_t k = 0; k < n; ++k) {
+        Goldilocks::mul(a[k], a[k], wk);
+        Goldilocks::mul(wk, wk, w);
+    }
+}
+
+void butterfly_ext_scalar(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end){
+    for (size_t j = begin; j < end; ++j) {
+        auto &u = a[j];
+        auto &v = a[j + half];
+        for (size_t c = 0; c < 2; ++c) {
+            Goldilocks::Element t = Goldilocks::mul(w[j], v[c]);
+            v[c] = u[c] - t;
+            u[c] = u[c] + t;
+        }
+    }
+}
+
+void scale_powers_ext_scalar(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w){
+    Goldilocks::Element wk = Goldilocks::one();
+    for (size_t k = 0; k < n; ++k) {
+        Goldilocks2::mul(a[k], a[k], wk);
+        Goldilocks::mul(wk, wk, w);
+    }
+}
+
+// ======== AVX2 ========
+// AVX2 has no unsigned 64-bit compare, compare with the sign bits flipped instead
+static inline __m256i ltu_avx2(const __m256i& a, const __m256i& b){
+    const __m256i sign = _mm256_set1_epi64x(0x8000000000000000ull);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+}
+
+static inline __m256i canonical_avx2(const __m256i& a){
+    const __m256i p = _mm256_set1_epi64x(GL_P);
+    // a >= p  <=>  !(a < p)
+    const __m256i lt = ltu_avx2(a, p);
+    return _mm256_sub_epi64(a, _mm256_andnot_si256(lt, p));
+}
+
+static inline __m256i add_avx2(const __m256i& a, const __m256i& b){
+    const __m256i eps = _mm256_set1_epi64x(GL_EPSILON);
+    __m256i s = _mm256_add_epi64(a, b);
+    s = _mm256_add_epi64(s, _mm256_and_si256(ltu_avx2(s, a), eps));
+    return canonical_avx2(s);
+}
+
+static inline __m256i sub_avx2(const __m256i& a, const __m256i& b){
+    const __m256i eps = _mm256_set1_epi64x(GL_EPSILON);
+    __m256i d = _mm256_sub_epi64(a, b);
+    return _mm256_sub_epi64(d, _mm256_and_si256(ltu_avx2(a, b), eps));
+}
+
+static inline __m256i mul_avx2(const __m256i& a, const __m256i& b){
+    const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFull);
+    const __m256i eps = _mm256_set1_epi64x(GL_EPSILON);
+    const __m256i ah = _mm256_srli_epi64(a, 32), bh = _mm256_srli_epi64(b, 32);
+    // 32x32 partial products
+    const __m256i ll = _mm256_mul_epu32(a, b);
+    const __m256i lh = _mm256_mul_epu32(a, bh);
+    const __m256i hl = _mm256_mul_epu32(ah, b);
+    const __m256i hh = _mm256_mul_epu32(ah, bh);
+    // none of the sums below overflows 64 bits
+    const __m256i t = _mm256_add_epi64(hl, _mm256_srli_epi64(ll, 32));
+    const __m256i u = _mm256_add_epi64(lh, _mm256_and_si256(t, lo32));
+    const __m256i lo = _mm256_or_si256(_mm256_slli_epi64(u, 32), _mm256_and_si256(ll, lo32));
+    const __m256i hi = _mm256_add_epi64(hh, _mm256_add_epi64(_mm256_srli_epi64(t, 32), _mm256_srli_epi64(u, 32)));
+
+    // lo + hi * 2^64 = lo + hi_lo * EPSILON - hi_hi  (2^96 = -1)
+    const __m256i hi_hi = _mm256_srli_epi64(hi, 32);
+    __m256i r = _mm256_sub_epi64(lo, hi_hi);
+    r = _mm256_sub_epi64(r, _mm256_and_si256(ltu_avx2(lo, hi_hi), eps));
+    const __m256i hi_lo_eps = _mm256_mul_epu32(hi, eps);
+    __m256i s = _mm256_add_epi64(r, hi_lo_eps);
+    s = _mm256_add_epi64(s, _mm256_and_si256(ltu_avx2(s, r), eps));
+    return canonical_avx2(s);
+}
+
+void butterfly_avx2(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end){
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        __m256i u = canonical_avx2(_mm256_loadu_si256((const __m256i*)(a + j)));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + j + half));
+        __m256i wj = _mm256_loadu_si256((const __m256i*)(w + j));
+        __m256i t = mul_avx2(wj, v);
+        _mm256_storeu_si256((__m256i*)(a + j), add_avx2(u, t));
+        _mm256_storeu_si256((__m256i*)(a + j + half), sub_avx2(u, t));
+    }
+    butterfly_scalar(a, half, w, j, end);
+}
+
+void scale_powers_avx2(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w){
+    if (n < 8) return scale_powers_scalar(a, n, w);
+    // lane l holds w^{k + l}, advanced by w^4 per vector
+    Goldilocks::Element pw[4];
+    pw[0] = Goldilocks::one();
+    for (size_t l = 1; l < 4; ++l) Goldilocks::mul(pw[l], pw[l - 1], w);
+    const __m256i step = _mm256_set1_epi64x(Goldilocks::toU64(Goldilocks::mul(pw[3], w)));
+    __m256i wk = _mm256_loadu_si256((const __m256i*)pw);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        _mm256_storeu_si256((__m256i*)(a + k), mul_avx2(_mm256_loadu_si256((const __m256i*)(a + k)), wk));
+        wk = mul_avx2(wk, step);
+    }
+    _mm256_storeu_si256((__m256i*)pw, wk);
+    for (size_t l = 0; k < n; ++k, ++l) Goldilocks::mul(a[k], a[k], pw[l]);
+}
+
+// extension elements are two adjacent lanes, every twiddle is loaded into both of them
+void butterfly_ext_avx2(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end){
+    size_t j = begin;
+    for (; j + 2 <= end; j += 2) {
+        __m256i u = canonical_avx2(_mm256_loadu_si256((const __m256i*)(a + j)));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + j + half));
+        // (w_j, w_j, w_{j+1}, w_{j+1})
+        __m256i wj = _mm256_permute4x64_epi64(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(w + j))), 0x50);
+        __m256i t = mul_avx2(wj, v);
+        _mm256_storeu_si256((__m256i*)(a + j), add_avx2(u, t));
+        _mm256_storeu_si256((__m256i*)(a + j + half), sub_avx2(u, t));
+    }
+    butterfly_ext_scalar(a, half, w, j, end);
+}
+
+void scale_powers_ext_avx2(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w){
+    if (n < 4) return scale_powers_ext_scalar(a, n, w);
+    // lanes (w^k, w^k, w^{k+1}, w^{k+1}), advanced by w^2 per vector
+    Goldilocks::Element pw[4];
+    pw[0] = pw[1] = Goldilocks::one();
+    pw[2] = pw[3] = w;
+    const __m256i step = _mm256_set1_epi64x(Goldilocks::toU64(Goldilocks::mul(w, w)));
+    __m256i wk = _mm256_loadu_si256((const __m256i*)pw);
+    size_t k = 0;
+    for (; k + 2 <= n; k += 2) {
+        _mm256_storeu_si256((__m256i*)(a + k), mul_avx2(_mm256_loadu_si256((const __m256i*)(a + k)), wk));
+        wk = mul_avx2(wk, step);
+    }
+    _mm256_storeu_si256((__m256i*)pw, wk);
+    if (k < n) Goldilocks2::mul(a[k], a[k], pw[0]);
+}
+
+// ======== AVX-512 ========
+// compiled for avx512f regardless of the global flags, only called after a cpu check
+#define AVX512_TARGET __attribute__((target("avx512f")))
+// gcc 12 reports the _mm512_undefined operands inside the shift/multiply intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+AVX512_TARGET static inline __m512i canonical_avx512(const __m512i& a){
+    const __m512i p = _mm512_set1_epi64(GL_P);
+    return _mm512_mask_sub_epi64(a, _mm512_cmpge_epu64_mask(a, p), a, p);
+}
+
+AVX512_TARGET static inline __m512i add_avx512(const __m512i& a, const __m512i& b){
+    const __m512i eps = _mm512_set1_epi64(GL_EPSILON);
+    __m512i s = _mm512_add_epi64(a, b);
+    s = _mm512_mask_add_epi64(s, _mm512_cmplt_epu64_mask(s, a), s, eps);
+    return canonical_avx512(s);
+}
+
+AVX512_TARGET static inline __m512i sub_avx512(const __m512i& a, const __m512i& b){
+    const __m512i eps = _mm512_set1_epi64(GL_EPSILON);
+    __m512i d = _mm512_sub_epi64(a, b);
+    return _mm512_mask_sub_epi64(d, _mm512_cmplt_epu64_mask(a, b), d, eps);
+}
+
+AVX512_TARGET static inline __m512i mul_avx512(const __m512i& a, const __m512i& b){
+    const __m512i lo32 = _mm512_set1_epi64(0xFFFFFFFFull);
+    const __m512i eps = _mm512_set1_epi64(GL_EPSILON);
+    const __m512i ah = _mm512_srli_epi64(a, 32), bh = _mm512_srli_epi64(b, 32);
+    const __m512i ll = _mm512_mul_epu32(a, b);
+    const __m512i lh = _mm512_mul_epu32(a, bh);
+    const __m512i hl = _mm512_mul_epu32(ah, b);
+    const __m512i hh = _mm512_mul_epu32(ah, bh);
+    const __m512i t = _mm512_add_epi64(hl, _mm512_srli_epi64(ll, 32));
+    const __m512i u = _mm512_add_epi64(lh, _mm512_and_si512(t, lo32));
+    const __m512i lo = _mm512_or_si512(_mm512_slli_epi64(u, 32), _mm512_and_si512(ll, lo32));
+    const __m512i hi = _mm512_add_epi64(hh, _mm512_add_epi64(_mm512_srli_epi64(t, 32), _mm512_srli_epi64(u, 32)));
+
+    const __m512i hi_hi = _mm512_srli_epi64(hi, 32);
+    __m512i r = _mm512_sub_epi64(lo, hi_hi);
+    r = _mm512_mask_sub_epi64(r, _mm512_cmplt_epu64_mask(lo, hi_hi), r, eps);
+    __m512i s = _mm512_add_epi64(r, _mm512_mul_epu32(hi, eps));
+    s = _mm512_mask_add_epi64(s, _mm512_cmplt_epu64_mask(s, r), s, eps);
+    return canonical_avx512(s);
+}
+
+AVX512_TARGET void butterfly_avx512(Goldilocks::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end){
+    size_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        __m512i u = canonical_avx512(_mm512_loadu_si512((const void*)(a + j)));
+        __m512i v = _mm512_loadu_si512((const void*)(a + j + half));
+        __m512i wj = _mm512_loadu_si512((const void*)(w + j));
+        __m512i t = mul_avx512(wj, v);
+        _mm512_storeu_si512((void*)(a + j), add_avx512(u, t));
+        _mm512_storeu_si512((void*)(a + j + half), sub_avx512(u, t));
+    }
+    butterfly_avx2(a, half, w, j, end);
+}
+
+AVX512_TARGET void scale_powers_avx512(Goldilocks::Element* a, const size_t& n, const Goldilocks::Element& w){
+    if (n < 16) return scale_powers_avx2(a, n, w);
+    Goldilocks::Element pw[8];
+    pw[0] = Goldilocks::one();
+    for (size_t l = 1; l < 8; ++l) Goldilocks::mul(pw[l], pw[l - 1], w);
+    const __m512i step = _mm512_set1_epi64(Goldilocks::toU64(Goldilocks::mul(pw[7], w)));
+    __m512i wk = _mm512_loadu_si512((const void*)pw);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        _mm512_storeu_si512((void*)(a + k), mul_avx512(_mm512_loadu_si512((const void*)(a + k)), wk));
+        wk = mul_avx512(wk, step);
+    }
+    _mm512_storeu_si512((void*)pw, wk);
+    for (size_t l = 0; k < n; ++k, ++l) Goldilocks::mul(a[k], a[k], pw[l]);
+}
+
+AVX512_TARGET void butterfly_ext_avx512(Goldilocks2::Element* a, const size_t& half, const Goldilocks::Element* w, const size_t& begin, const size_t& end){
+    const __m512i dup = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        __m512i u = canonical_avx512(_mm512_loadu_si512((const void*)(a + j)));
+        __m512i v = _mm512_loadu_si512((const void*)(a + j + half));
+        __m512i wj = _mm512_permutexvar_epi64(dup, _mm512_castsi256_si512(_mm256_loadu_si256((const __m256i*)(w + j))));
+        __m512i t = mul_avx512(wj, v);
+        _mm512_storeu_si512((void*)(a + j), add_avx512(u, t));
+        _mm512_storeu_si512((void*)(a + j + half), sub_avx512(u, t));
+    }
+    butterfly_ext_avx2(a, half, w, j, end);
+}
+
+AVX512_TARGET void scale_powers_ext_avx512(Goldilocks2::Element* a, const size_t& n, const Goldilocks::Element& w){
+    if (n < 8) return scale_powers_ext_avx2(a, n, w);
+    // lanes 2l and 2l + 1 hold w^{k + l}, advanced by w^4 per vector
+    Goldilocks::Element pw[8];
+    pw[0] = pw[1] = Goldilocks::one();
+    for (size_t l = 1; l < 4; ++l) pw[2 * l] = pw[2 * l + 1] = Goldilocks::mul(pw[2 * l - 1], w);
+    const __m512i step = _mm512_set1_epi64(Goldilocks::toU64(Goldilocks::mul(pw[7], w)));
+    __m512i wk = _mm512_loadu_si512((const void*)pw);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        _mm512_storeu_si512((void*)(a + k), mul_avx512(_mm512_loadu_si512((const void*)(a + k)), wk));
+        wk = mul_avx512(wk, step);
+    }
+    _mm512_storeu_si512((void*)pw, wk);
+    for (size_t l = 0; k < n; ++k, ++l) Goldilocks2::mul(a[k], a[k], pw[2 * l]);
+}
+#pragma GCC diagnostic pop
+
+// ======== dispatch ========
+bool ntt_kernel_supported(const NTTKernel& kernel){
+    switch(kernel){
+        case NTTKernel::AVX512: return __builtin_cpu_supports("avx512f");
+        case NTTKernel::AVX2: return __builtin_cpu_supports("avx2");
+        default: return true;
+    }
+}
+
+static const NTTKernelSet kernel_sets[] = {
+    {butterfly_scalar, butterfly_ext_scalar, scale_powers_scalar, scale_powers_ext_scalar},
+    {butterfly_avx2, butterfly_ext_avx2, scale_powers_avx2, scale_powers_ext_avx2},
+    {butterfly_avx512, butterfly_ext_avx512, scale_powers_avx512, scale_powers_ext_avx512},
+};
+
+static const NTTKernelSet* resolve_kernels(const NTTKernel& kernel){
+    switch(kernel){
+        case NTTKernel::Scalar: return &kernel_sets[0];
+        case NTTKernel::AVX2: return &kernel_sets[1];
+        case NTTKernel::AVX512: return &kernel_sets[2];
+        default:
+            if(ntt_kernel_supported(NTTKernel::AVX512)) return &kernel_sets[2];
+            if(ntt_kernel_supported(NTTKernel::AVX2)) return &kernel_sets[1];
+            return &kernel_sets[0];
+    }
+}
+
+static std::atomic<const NTTKernelSet*> active_kernels{nullptr};
+
+bool set_ntt_kernel(const NTTKernel& kernel){
+    if(!ntt_kernel_supported(kernel)) return false;
+    active_kernels.store(resolve_kernels(kernel));
+    return true;
+}
+
+const NTTKernelSet& get_ntt_kernels(){
+    const NTTKernelSet* kernels = active_kernels.load(std::memory_order_relaxed);
+    if(kernels == nullptr){
+        kernels = resolve_kernels(NTTKernel::Auto);
+        active_kernels.store(kernels);
+    }
+    return *kernels;
+}
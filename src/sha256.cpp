@@ -0,0 +1,273 @@
+#include "sha256.h"
+#include <immintrin.h>
+#include <cpuid.h>
+#include <atomic>
+#include <cstring>
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// compress nblocks consecutive 64-byte blocks into state
+typedef void (*CompressFn)(uint32_t* state, const uint8_t* blocks, const size_t& nblocks);
+
+static inline uint32_t load_be32(const uint8_t* p){
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline void store_be32(uint8_t* p, const uint32_t& x){
+    p[0] = x >> 24;
+    p[1] = x >> 16;
+    p[2] = x >> 8;
+    p[3] = x;
+}
+
+// the last len % 64 bytes of a message of len bytes followed by the padding, returns the number of blocks (1 or 2)
+static size_t pad_tail(const uint8_t* data, const size_t& len, uint8_t* tail){
+    const size_t rem = len % SHA256_BLOCK_BYTES;
+    const size_t nblocks = rem + 9 > SHA256_BLOCK_BYTES ? 2 : 1;
+    std::memset(tail, 0, nblocks * SHA256_BLOCK_BYTES);
+    if (rem) std::memcpy(tail, data + len - rem, rem);
+    tail[rem] = 0x80;
+    const uint64_t bits = uint64_t(len) << 3;
+    uint8_t* end = tail + nblocks * SHA256_BLOCK_BYTES;
+    store_be32(end - 8, uint32_t(bits >> 32));
+    store_be32(end - 4, uint32_t(bits));
+    return nblocks;
+}
+
+// ======== scalar ========
+static inline uint32_t rotr(const uint32_t& x, const int& n){
+    return (x >> n) | (x << (32 - n));
+}
+
+static void compress_scalar(uint32_t* state, const uint8_t* blocks, const size_t& nblocks){
+    uint32_t w[64];
+    for (size_t blk = 0; blk < nblocks; ++blk, blocks += SHA256_BLOCK_BYTES) {
+        for (int t = 0; t < 16; ++t) w[t] = load_be32(blocks + 4 * t);
+        for (int t = 16; t < 64; ++t) {
+            const uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            const uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+// ======== SHA-NI ========
+// compiled for the sha extensions regardless of the global flags, only called after a cpu check
+#define SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+/*
+the state is kept as (A, B, E, F) and (C, D, G, H), the layout sha256rnds2 works on.
+every group of 4 rounds adds K to its 4 message words, runs two sha256rnds2 and extends the schedule
+4 words ahead with sha256msg1 / sha256msg2 (groups 3 to 14), rotating through msg[0..3]
+*/
+SHANI_TARGET static void compress_shani(uint32_t* state, const uint8_t* blocks, const size_t& nblocks){
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xB1);   // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1B);   // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);   // CDGH
+
+    for (size_t blk = 0; blk < nblocks; ++blk, blocks += SHA256_BLOCK_BYTES) {
+        const __m128i abef = state0, cdgh = state1;
+        __m128i msg[4];
+        #pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g) {
+            __m128i& cur = msg[g & 3];
+            if (g < 4) cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16 * g)), bswap);
+            __m128i m = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i*)(K + 4 * g)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+            if (g >= 3 && g <= 14) {
+                __m128i& next = msg[(g + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msg[(g - 1) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, cur);
+            }
+            m = _mm_shuffle_epi32(m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+            if (g >= 1 && g <= 12) {
+                __m128i& prev = msg[(g - 1) & 3];
+                prev = _mm_sha256msg1_epu32(prev, cur);
+            }
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);   // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);   // DCHG
+    _mm_storeu_si128((__m128i*)state, _mm_blend_epi16(tmp, state1, 0xF0));   // DCBA
+    _mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(state1, tmp, 8));   // HGFE
+}
+
+// ======== AVX2, 8 messages ========
+static inline __m256i rotr_avx2(const __m256i& x, const int& n){
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+static inline __m256i bswap_avx2(const __m256i& x){
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm256_shuffle_epi8(x, mask);
+}
+
+// 8 x 8 matrix of 32-bit words, rows in r, transposed in place
+static inline void transpose8_avx2(__m256i* r){
+    __m256i t[8], u[8];
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+// one block of each of the 8 messages, block l at p[l]
+static void block_avx2(__m256i* state, const uint8_t* const* p){
+    __m256i w[16];
+    for (int half = 0; half < 2; ++half) {
+        for (int l = 0; l < SHA256_LANES; ++l) w[8 * half + l] = _mm256_loadu_si256((const __m256i*)(p[l] + 32 * half));
+        transpose8_avx2(w + 8 * half);
+    }
+    for (int t = 0; t < 16; ++t) w[t] = bswap_avx2(w[t]);
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; ++t) {
+        __m256i& wt = w[t & 15];
+        if (t >= 16) {
+            const __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(w15, 7), rotr_avx2(w15, 18)), _mm256_srli_epi32(w15, 3));
+            const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(w2, 17), rotr_avx2(w2, 19)), _mm256_srli_epi32(w2, 10));
+            wt = _mm256_add_epi32(_mm256_add_epi32(wt, s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+        const __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(e, 6), rotr_avx2(e, 11)), rotr_avx2(e, 25));
+        const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, S1), _mm256_add_epi32(ch, wt)), _mm256_set1_epi32(K[t]));
+        const __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(rotr_avx2(a, 2), rotr_avx2(a, 13)), rotr_avx2(a, 22));
+        const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(t1, _mm256_add_epi32(S0, maj));
+    }
+    state[0] = _mm256_add_epi32(state[0], a); state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c); state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e); state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g); state[7] = _mm256_add_epi32(state[7], h);
+}
+
+static void hash8_avx2(const uint8_t* const* data, const size_t& len, uint8_t* const* digests){
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i) state[i] = _mm256_set1_epi32(IV[i]);
+    const uint8_t* p[SHA256_LANES];
+    for (size_t off = 0; off + SHA256_BLOCK_BYTES <= len; off += SHA256_BLOCK_BYTES) {
+        for (int l = 0; l < SHA256_LANES; ++l) p[l] = data[l] + off;
+        block_avx2(state, p);
+    }
+    // equal lengths, so every lane has the same number of padding blocks
+    alignas(32) uint8_t tails[SHA256_LANES][2 * SHA256_BLOCK_BYTES];
+    size_t ntail = 0;
+    for (int l = 0; l < SHA256_LANES; ++l) ntail = pad_tail(data[l], len, tails[l]);
+    for (size_t blk = 0; blk < ntail; ++blk) {
+        for (int l = 0; l < SHA256_LANES; ++l) p[l] = tails[l] + blk * SHA256_BLOCK_BYTES;
+        block_avx2(state, p);
+    }
+    // rows are state words, columns lanes: after the transpose row l is the state of message l
+    transpose8_avx2(state);
+    for (int l = 0; l < SHA256_LANES; ++l) _mm256_storeu_si256((__m256i*)digests[l], bswap_avx2(state[l]));
+}
+
+// ======== dispatch ========
+static bool cpu_has_shani(){
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    return (ebx >> 29) & 1;
+}
+
+bool sha256_engine_supported(const SHA256Engine& engine){
+    switch(engine){
+        case SHA256Engine::SHANI: return cpu_has_shani() && __builtin_cpu_supports("sse4.1");
+        case SHA256Engine::AVX2: return __builtin_cpu_supports("avx2");
+        default: return true;
+    }
+}
+
+static SHA256Engine resolve_engine(const SHA256Engine& engine){
+    if(engine != SHA256Engine::Auto) return engine;
+    if(sha256_engine_supported(SHA256Engine::SHANI)) return SHA256Engine::SHANI;
+    if(sha256_engine_supported(SHA256Engine::AVX2)) return SHA256Engine::AVX2;
+    return SHA256Engine::Scalar;
+}
+
+static std::atomic<SHA256Engine> active_engine{SHA256Engine::Auto};
+
+bool set_sha256_engine(const SHA256Engine& engine){
+    if(!sha256_engine_supported(engine)) return false;
+    active_engine.store(resolve_engine(engine));
+    return true;
+}
+
+static SHA256Engine get_engine(){
+    SHA256Engine engine = active_engine.load(std::memory_order_relaxed);
+    if(engine == SHA256Engine::Auto){
+        engine = resolve_engine(SHA256Engine::Auto);
+        active_engine.store(engine);
+    }
+    return engine;
+}
+
+static void hash_one(const CompressFn& compress, const uint8_t* data, const size_t& len, uint8_t* digest){
+    uint32_t state[8];
+    std::memcpy(state, IV, sizeof(IV));
+    compress(state, data, len / SHA256_BLOCK_BYTES);
+    uint8_t tail[2 * SHA256_BLOCK_BYTES];
+    compress(state, tail, pad_tail(data, len, tail));
+    for (int i = 0; i < 8; ++i) store_be32(digest + 4 * i, state[i]);
+}
+
+void sha256(const uint8_t* data, const size_t& len, uint8_t* digest){
+    // the AVX2 engine only helps with several messages, a single one goes through the scalar rounds
+    hash_one(get_engine() == SHA256Engine::SHANI ? compress_shani : compress_scalar, data, len, digest);
+}
+
+void sha256_many(const uint8_t* const* data, const size_t& len, uint8_t* const* digests, const size_t& n){
+    const SHA256Engine engine = get_engine();
+    size_t i = 0;
+    if(engine == SHA256Engine::AVX2){
+        for(; i + SHA256_LANES <= n; i += SHA256_LANES){
+            hash8_avx2(data + i, len, digests + i);
+        }
+    }
+    const CompressFn compress = engine == SHA256Engine::SHANI ? compress_shani : compress_scalar;
+    for(; i < n; ++i){
+        hash_one(compress, data[i], len, digests[i]);
+    }
+}
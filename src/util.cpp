@@ -194,134 +194,3 @@ Goldilocks2::Element Horner(const std::vector<Goldilocks2::Element> &coefs, cons
     }
     return res;
 }
-
-void in_place_NTT(std::vector<Goldilocks::Element>& a) {
-    const size_t n = a.size();
-    const size_t m = find_ceiling_log2(n);
-
-    // Bit-reverse permutation
-    for (size_t i = 1, j = 0; i < n; ++i) {
-        size_t bit = n >> 1;
-        for (; j & bit; bit >>= 1)
-            j ^= bit;
-        j ^= bit;
-        if (i < j) std::swap(a[i], a[j]);
-    }
-
-    // Iterative Cooley-Tukey NTT
-    for (size_t len = 2, level = 1; len <= n; len <<= 1, ++level) {
-        size_t half = len >> 1;
-        Goldilocks::Element w_len = ROOTS[level]; // omega^(N / len)
-        for (size_t i = 0; i < n; i += len) {
-            Goldilocks::Element w = Goldilocks::one();
-            for (size_t j = 0; j < half; ++j) {
-                auto &u = a[i + j];
-                auto &v = a[i + j + half];
-                Goldilocks::Element t = Goldilocks::mul(w, v);
-                v = u - t;
-                u = u + t;
-                Goldilocks::mul(w, w, w_len);
-            }
-        }
-    }
-}
-
-std::vector<Goldilocks::Element> NTT(const std::vector<Goldilocks::Element>& input) {
-    std::vector<Goldilocks::Element> a = input;
-    in_place_NTT(a);
-    return a;
-}
-
-// std::vector<Goldilocks::Element> NTT(const std::vector<Goldilocks::Element>& coefs){
-//     if (coefs.size() == 1) return coefs;
-
-//     const size_t n = coefs.size();
-//     const size_t m = find_ceiling_log2(n);
-
-//     // calculate f1, f2;
-//     std::vector<Goldilocks::Element> even(n >> 1), odd(n >> 1);
-//     for(size_t i = 0;i < n; ++i){
-//         if (i & 1) odd[i >> 1] = coefs[i];
-//         else even[i >> 1] = coefs[i];
-//     }
-//     std::vector<Goldilocks::Element> f1 = NTT(even);
-//     std::vector<Goldilocks::Element> f2 = NTT(odd);
-
-//     std::vector<Goldilocks::Element> f(n);
-//     const size_t offset = n >> 1;
-//     Goldilocks::Element wn = Goldilocks::one();
-//     // traverse and calculate f
-//     for (size_t i = 0; i < offset; ++i){
-//         f[i] = f1[i] + Goldilocks::mul(wn, f2[i]);
-//         f[i + offset] = f1[i] - Goldilocks::mul(wn, f2[i]);
-//         Goldilocks::mul(wn, wn, ROOTS[m]);
-//     }
-
-//     return f;
-// }
-
-size_t highest_bit_mask(const size_t& n){
-    size_t mask = SIZE_MAX;
-    while(mask != 0){
-        if(mask & n) return mask;
-        mask = mask >> 1;
-    }
-    return 0;
-}
-
-std::vector<Goldilocks::Element> eval_with_ntt(std::vector<Goldilocks::Element> f, const size_t& N){
-    std::reverse(f.begin(), f.end());
-    // N is not power of 2, pad N and trim when return
-    if(!is_power_of_2(N)){
-        size_t padded_N = highest_bit_mask(N) << 1;
-        f.resize(padded_N, Goldilocks::zero());
-        std::vector<Goldilocks::Element> raw_output = NTT(f);
-        raw_output.resize(N);
-        return raw_output;
-    }
-
-    // N is power of 2
-    f.resize(N, Goldilocks::zero());
-    return NTT(f);
-}
-
-std::vector<Goldilocks2::Element> eval_with_ntt(std::vector<Goldilocks2::Element> f, const size_t& N){
-    std::reverse(f.begin(), f.end());
-
-    size_t N_used = is_power_of_2(N) ? N : highest_bit_mask(N) << 1;
-    f.resize(N_used, Goldilocks2::zero());
-
-    std::vector<Goldilocks::Element> real(f.size()), imag(f.size());
-    for(size_t i = 0; i < f.size(); ++i){
-        real[i] = f[i][0];
-        imag[i] = f[i][1];
-    }
-    
-    std::vector<Goldilocks::Element> real_ntt = NTT(real);
-    std::vector<Goldilocks::Element> imag_ntt = NTT(imag);
-
-    std::vector<Goldilocks2::Element> result(N);
-    for(size_t i = 0; i < N; ++i){
-        result[i][0] = real_ntt[i];
-        result[i][1] = imag_ntt[i];
-    }
-    return result;
-}
-
-std::vector<Goldilocks::Element> eval_with_ntt_base(std::vector<Goldilocks2::Element> f, const size_t& N){
-    std::vector<Goldilocks::Element> base_field_copy(f.size());
-    for(size_t i = 0; i < f.size(); ++i){
-        base_field_copy[i] = f[i][0];
-    }
-    return eval_with_ntt(base_field_copy, N);
-}
-
-std::vector<Goldilocks2::Element> eval_with_ntt_ext(std::vector<Goldilocks2::Element> f, const size_t& N){
-    std::vector<Goldilocks::Element> base = eval_with_ntt_base(f, N);
-    std::vector<Goldilocks2::Element> ext(base.size());
-    for (size_t i = 0;i < base.size(); ++i){
-        ext[i][0] = base[i];
-        ext[i][1] = Goldilocks::zero();
-    }
-    return ext;
-}